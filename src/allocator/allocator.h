@@ -3,20 +3,26 @@
 
 #include <stdlib.h>
 
-#include "../../../MemCraft/mem_alloc.h"
+#include "arena.h"
+#include "pool_allocator.h"
 
 typedef void *(*allocator_t)(size_t size);
 typedef void (*deallocator_t)(void *ptr);
 
 void change_allocator_to_default();
 void change_allocator_to_custom();
+void change_allocator_to_arena(arena_t *arena);
 
 void *default_allocator(size_t size);
 void default_deallocator(void *ptr);
 void *custom_allocator(size_t size);
 void custom_deallocator(void *ptr);
+void *arena_allocator(size_t size);
+void arena_deallocator(void *ptr);
 
-// #define CUSTOM_ALLOCATOR
+arena_t *current_arena = NULL; // target of arena_allocator
+
+// #define CUSTOM_ALLOCATOR // pooled size classes (pool_allocator.h) instead of malloc
 
 allocator_t allocate =
 #ifndef CUSTOM_ALLOCATOR
@@ -44,12 +50,22 @@ void default_deallocator(void *ptr)
 
 void *custom_allocator(size_t size)
 {
-    return heap_alloc(size, ALIGN_DEFAULT);
+    return pool_alloc(size);
 }
 
 void custom_deallocator(void *ptr)
 {
-    heap_free(ptr);
+    pool_free(ptr);
+}
+
+void *arena_allocator(size_t size)
+{
+    return arena_alloc(current_arena, size);
+}
+
+void arena_deallocator(void *ptr)
+{
+    arena_free(current_arena, ptr);
 }
 
 void change_allocator_to_default()
@@ -64,4 +80,11 @@ void change_allocator_to_custom()
     deallocate = custom_deallocator;
 }
 
+void change_allocator_to_arena(arena_t *arena)
+{
+    current_arena = arena;
+    allocate = arena_allocator;
+    deallocate = arena_deallocator;
+}
+
 #endif /* B4E8B570_191E_40E7_BFB3_10EB1EAE4545 */
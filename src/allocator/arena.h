@@ -0,0 +1,187 @@
+#ifndef D41E8A27_93B5_4F6C_A0D8_5C27E1B96F34
+#define D41E8A27_93B5_4F6C_A0D8_5C27E1B96F34
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+A bump-pointer arena. Nodes that live and die with a compiler phase are carved out of
+large blocks and the whole phase is released at once with arena_release.
+Requests of ARENA_LARGE_ALLOCATION bytes or more (instruction arrays that keep being
+regrown) get their own heap block, so that freeing them early actually returns memory.
+
+arena_free is not told the size, the word right in front of the pointer tells instead: a
+large allocation keeps its owner there, mixed with ARENA_LARGE_TAG. Small allocations and
+those of another arena are left alone without searching for them.
+*/
+
+#define ARENA_BLOCK_SIZE (256 * 1024)
+#define ARENA_LARGE_ALLOCATION 2048
+#define ARENA_ALIGNMENT 16
+#define ARENA_LARGE_TAG ((uintptr_t)0x6C61726765A11CULL)
+
+typedef struct arena_block_
+{
+    struct arena_block_ *next;
+    size_t used;
+    size_t capacity;
+    uintptr_t tag; // always 0, so the first allocation in a block never looks large
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+} arena_block_t;
+
+typedef struct arena_large_
+{
+    struct arena_large_ *prev;
+    struct arena_large_ *next;
+    size_t size;
+    uintptr_t tag;
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+} arena_large_t;
+
+typedef struct
+{
+    arena_block_t *blocks;
+    arena_large_t *large;
+    size_t bytes_allocated;
+} arena_t;
+
+void arena_init(arena_t *arena);
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_free(arena_t *arena, void *ptr);
+void arena_release(arena_t *arena);
+
+void arena_init(arena_t *arena)
+{
+    arena->blocks = NULL;
+    arena->large = NULL;
+    arena->bytes_allocated = 0;
+}
+
+static void *arena_alloc_large(arena_t *arena, size_t size)
+{
+    arena_large_t *large = (arena_large_t *)malloc(sizeof(arena_large_t) + size);
+    if (!large)
+    {
+        return NULL;
+    }
+
+    large->prev = NULL;
+    large->next = arena->large;
+    large->size = size;
+    large->tag = (uintptr_t)arena ^ ARENA_LARGE_TAG;
+    if (arena->large)
+    {
+        arena->large->prev = large;
+    }
+    arena->large = large;
+
+    arena->bytes_allocated += size;
+    return large->data;
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    if (!arena)
+    {
+        return NULL;
+    }
+
+    if (size >= ARENA_LARGE_ALLOCATION)
+    {
+        return arena_alloc_large(arena, size);
+    }
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    arena_block_t *block = arena->blocks;
+    if (!block || block->capacity - block->used < size)
+    {
+        block = (arena_block_t *)malloc(sizeof(arena_block_t) + ARENA_BLOCK_SIZE);
+        if (!block)
+        {
+            return NULL;
+        }
+
+        block->used = 0;
+        block->capacity = ARENA_BLOCK_SIZE;
+        block->tag = 0;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->bytes_allocated += size;
+    return ptr;
+}
+
+// Only large allocations are given back, everything else waits for arena_release
+void arena_free(arena_t *arena, void *ptr)
+{
+    if (!arena || !ptr)
+    {
+        return;
+    }
+
+    arena_large_t *large = (arena_large_t *)((unsigned char *)ptr - offsetof(arena_large_t, data));
+    if (large->tag != ((uintptr_t)arena ^ ARENA_LARGE_TAG))
+    {
+        return;
+    }
+
+    if (large->prev)
+    {
+        large->prev->next = large->next;
+    }
+    else
+    {
+        arena->large = large->next;
+    }
+
+    if (large->next)
+    {
+        large->next->prev = large->prev;
+    }
+
+    // malloc hands the memory out again with whatever it held, a stale tag could make a
+    // later small allocation look large
+    large->tag = 0;
+    arena->bytes_allocated -= large->size;
+    free(large);
+}
+
+void arena_release(arena_t *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+
+    arena_block_t *block = arena->blocks;
+    while (block)
+    {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena_large_t *large = arena->large;
+    while (large)
+    {
+        arena_large_t *next = large->next;
+        large->tag = 0;
+        free(large);
+        large = next;
+    }
+
+    arena_init(arena);
+}
+
+#undef ARENA_BLOCK_SIZE
+#undef ARENA_LARGE_ALLOCATION
+#undef ARENA_ALIGNMENT
+#undef ARENA_LARGE_TAG
+
+#endif /* D41E8A27_93B5_4F6C_A0D8_5C27E1B96F34 */
@@ -0,0 +1,213 @@
+#ifndef F50B7C3A_E1D2_4A96_B8F4_2C6D9E07A153
+#define F50B7C3A_E1D2_4A96_B8F4_2C6D9E07A153
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+Pooled allocator with one free list per size class. Node structs are all small multiples
+of eight bytes, so the classes are spaced eight bytes apart and every node type gets an
+exact fit. Each chunk is preceded by an eight byte header holding its class, which is how
+pool_free finds the right list. Anything bigger than the last class goes to malloc.
+*/
+
+#define POOL_GRANULARITY 8
+#define POOL_CLASS_COUNT 32 // classes of 8, 16, ..., 256 bytes
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_LARGE_CLASS UINT64_MAX
+
+typedef union pool_header_
+{
+    uint64_t size_class;
+    union pool_header_ *next_free; // only while the chunk sits on a free list
+} pool_header_t;
+
+typedef struct pool_slab_
+{
+    struct pool_slab_ *next;
+    size_t used;
+    unsigned char data[];
+} pool_slab_t;
+
+typedef struct
+{
+    size_t allocations;
+    size_t frees;
+    size_t live;
+    size_t peak_live;
+    size_t slabs;
+} pool_class_stats_t;
+
+typedef struct
+{
+    pool_header_t *free_list;
+    pool_slab_t *slabs;
+    pool_class_stats_t stats;
+} pool_class_t;
+
+typedef struct
+{
+    pool_class_t classes[POOL_CLASS_COUNT];
+    pool_class_stats_t large;
+} pool_allocator_t;
+
+pool_allocator_t pool_allocator = {0};
+
+void *pool_alloc(size_t size);
+void pool_free(void *ptr);
+void pool_release(void);
+void pool_print_stats(FILE *stream);
+
+static inline size_t pool_chunk_size(size_t size_class)
+{
+    return sizeof(pool_header_t) + (size_class + 1) * POOL_GRANULARITY;
+}
+
+static void pool_count_allocation(pool_class_stats_t *stats)
+{
+    stats->allocations++;
+    stats->live++;
+    if (stats->live > stats->peak_live)
+    {
+        stats->peak_live = stats->live;
+    }
+}
+
+static pool_header_t *pool_carve(pool_class_t *pool, size_t size_class)
+{
+    size_t chunk_size = pool_chunk_size(size_class);
+    pool_slab_t *slab = pool->slabs;
+
+    if (!slab || POOL_SLAB_SIZE - slab->used < chunk_size)
+    {
+        slab = (pool_slab_t *)malloc(sizeof(pool_slab_t) + POOL_SLAB_SIZE);
+        if (!slab)
+        {
+            return NULL;
+        }
+
+        slab->used = 0;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->stats.slabs++;
+    }
+
+    pool_header_t *header = (pool_header_t *)(slab->data + slab->used);
+    slab->used += chunk_size;
+    return header;
+}
+
+void *pool_alloc(size_t size)
+{
+    if (!size)
+    {
+        size = 1;
+    }
+
+    size_t size_class = (size - 1) / POOL_GRANULARITY;
+    if (size_class >= POOL_CLASS_COUNT)
+    {
+        pool_header_t *header = (pool_header_t *)malloc(sizeof(pool_header_t) + size);
+        if (!header)
+        {
+            return NULL;
+        }
+
+        header->size_class = POOL_LARGE_CLASS;
+        pool_count_allocation(&pool_allocator.large);
+        return header + 1;
+    }
+
+    pool_class_t *pool = &pool_allocator.classes[size_class];
+    pool_header_t *header = pool->free_list;
+    if (header)
+    {
+        pool->free_list = header->next_free;
+    }
+    else
+    {
+        header = pool_carve(pool, size_class);
+        if (!header)
+        {
+            return NULL;
+        }
+    }
+
+    header->size_class = size_class;
+    pool_count_allocation(&pool->stats);
+    return header + 1;
+}
+
+void pool_free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    pool_header_t *header = (pool_header_t *)ptr - 1;
+    if (header->size_class == POOL_LARGE_CLASS)
+    {
+        pool_allocator.large.frees++;
+        pool_allocator.large.live--;
+        free(header);
+        return;
+    }
+
+    pool_class_t *pool = &pool_allocator.classes[header->size_class];
+    pool->stats.frees++;
+    pool->stats.live--;
+
+    header->next_free = pool->free_list;
+    pool->free_list = header;
+}
+
+// Drops every slab at once, chunks still in use become invalid
+void pool_release(void)
+{
+    for (size_t i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        pool_slab_t *slab = pool_allocator.classes[i].slabs;
+        while (slab)
+        {
+            pool_slab_t *next = slab->next;
+            free(slab);
+            slab = next;
+        }
+
+        pool_allocator.classes[i].slabs = NULL;
+        pool_allocator.classes[i].free_list = NULL;
+        pool_allocator.classes[i].stats.live = 0;
+    }
+}
+
+void pool_print_stats(FILE *stream)
+{
+    fprintf(stream, "Pool Allocator Statistics:\n");
+    fprintf(stream, "%8s %12s %12s %10s %10s %6s\n", "class", "allocs", "frees", "live", "peak", "slabs");
+
+    for (size_t i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        pool_class_stats_t *stats = &pool_allocator.classes[i].stats;
+        if (!stats->allocations)
+        {
+            continue;
+        }
+
+        fprintf(stream, "%8zu %12zu %12zu %10zu %10zu %6zu\n", (i + 1) * POOL_GRANULARITY,
+                stats->allocations, stats->frees, stats->live, stats->peak_live, stats->slabs);
+    }
+
+    pool_class_stats_t *large = &pool_allocator.large;
+    fprintf(stream, "%8s %12zu %12zu %10zu %10zu %6s\n", "large",
+            large->allocations, large->frees, large->live, large->peak_live, "-");
+}
+
+#undef POOL_GRANULARITY
+#undef POOL_CLASS_COUNT
+#undef POOL_SLAB_SIZE
+#undef POOL_LARGE_CLASS
+
+#endif /* F50B7C3A_E1D2_4A96_B8F4_2C6D9E07A153 */
@@ -200,13 +200,15 @@ asm_function_t *handle_function(function_def_t *function)
         return NULL;
     }
 
+    instr_list_init(&asm_function->instructions);
+
     switch (statement->stmt_type)
     {
     case STMT_RETURN:
-        asm_function->instruction_count = 2;
         for (size_t counter = 0; counter < 2; counter++)
         {
             asm_instructions[counter]->base.parent = &(asm_function->base);
+            instr_list_push_back(&asm_function->instructions, &asm_instructions[counter]->link);
         }
         break;
 
@@ -214,7 +216,7 @@ asm_function_t *handle_function(function_def_t *function)
         return NULL;
     }
 
-    asm_function->instructions = asm_instructions;
+    deallocate(asm_instructions);
     return asm_function;
 }
 
@@ -5,8 +5,6 @@
 #include "../../ast/IR/ir_ast.h"
 #include "../../allocator/allocator.h"
 
-#define MAX_INSTR_NO_IN_FXN 10000000
-
 typedef struct
 {
     asm_instruction_t **instructions;
@@ -36,6 +34,9 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
     ir_instruction_type_t ir_instruction_type = ir_instruction->type;
     switch (ir_instruction_type)
     {
+    case IR_INSTR_PHI:
+        // the optimizer leaves SSA form before code generation
+        return NULL_INSTRUCTION_STRUCT_ASM;
     case IR_INSTR_LABEL:
     {
         asm_instruction_t *asm_instruction_label = (asm_instruction_t *)allocate(sizeof(asm_instruction_t));
@@ -116,7 +117,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
         case IR_VAL_VARIABLE:
         {
             asm_src->type = OPERAND_PSEUDO;
-            asm_src->operand.pseudo.pseudo_name = copy_src->value.variable.identifier->name;
+            asm_src->operand.pseudo.vreg = copy_src->value.variable.vreg;
             break;
         }
         }
@@ -132,7 +133,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
         case IR_VAL_VARIABLE:
         {
             asm_dest->type = OPERAND_PSEUDO;
-            asm_dest->operand.pseudo.pseudo_name = copy_dest->value.variable.identifier->name;
+            asm_dest->operand.pseudo.vreg = copy_dest->value.variable.vreg;
             break;
         }
         }
@@ -232,7 +233,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             break;
         case IR_VAL_VARIABLE:
             cmp_first->type = OPERAND_PSEUDO;
-            cmp_first->operand.pseudo.pseudo_name = condition->value.variable.identifier->name;
+            cmp_first->operand.pseudo.vreg = condition->value.variable.vreg;
             break;
         default:
             return NULL_INSTRUCTION_STRUCT_ASM;
@@ -318,7 +319,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             break;
         case IR_VAL_VARIABLE:
             cmp_first->type = OPERAND_PSEUDO;
-            cmp_first->operand.pseudo.pseudo_name = condition->value.variable.identifier->name;
+            cmp_first->operand.pseudo.vreg = condition->value.variable.vreg;
             break;
         default:
             return NULL_INSTRUCTION_STRUCT_ASM;
@@ -415,7 +416,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
         case IR_VAL_VARIABLE:
         {
             asm_mov_src->type = OPERAND_PSEUDO;
-            asm_mov_src->operand.pseudo.pseudo_name = ir_return_value->value.variable.identifier->name;
+            asm_mov_src->operand.pseudo.vreg = ir_return_value->value.variable.vreg;
             break;
         }
         }
@@ -496,7 +497,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 cmp_first->type = OPERAND_PSEUDO;
-                cmp_first->operand.pseudo.pseudo_name = ir_unary_instr.source->value.variable.identifier->name;
+                cmp_first->operand.pseudo.vreg = ir_unary_instr.source->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -533,7 +534,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             mov_src->operand.immediate.value = 0;
 
             mov_dst->type = OPERAND_PSEUDO;
-            mov_dst->operand.pseudo.pseudo_name = ir_unary_instr.destination->value.variable.identifier->name;
+            mov_dst->operand.pseudo.vreg = ir_unary_instr.destination->value.variable.vreg;
 
             asm_instruction_mov->instr.mov = (asm_instruction_mov_t){
                 .src = mov_src,
@@ -557,7 +558,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             setcc_dst->base.type = ASM_NODE_OPERAND;
 
             setcc_dst->type = OPERAND_PSEUDO;
-            setcc_dst->operand.pseudo.pseudo_name = ir_unary_instr.destination->value.variable.identifier->name;
+            setcc_dst->operand.pseudo.vreg = ir_unary_instr.destination->value.variable.vreg;
 
             asm_instruction_setcc->instr.setcc = (asm_instruction_setcc_t){
                 .condition = COND_E, // Set if equal to zero
@@ -610,7 +611,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             case IR_VAL_VARIABLE:
             {
                 asm_mov_src->type = OPERAND_PSEUDO;
-                asm_mov_src->operand.pseudo.pseudo_name = ir_unary_instr.source->value.variable.identifier->name;
+                asm_mov_src->operand.pseudo.vreg = ir_unary_instr.source->value.variable.vreg;
                 break;
             }
             default:
@@ -618,7 +619,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             }
 
             asm_mov_dst->type = OPERAND_PSEUDO;
-            asm_mov_dst->operand.pseudo.pseudo_name = ir_unary_instr.destination->value.variable.identifier->name;
+            asm_mov_dst->operand.pseudo.vreg = ir_unary_instr.destination->value.variable.vreg;
 
             asm_instruction_mov->instr.mov = (asm_instruction_mov_t){.src = asm_mov_src, .dst = asm_mov_dst};
 
@@ -656,7 +657,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             }
 
             asm_unary_operand->type = OPERAND_PSEUDO;
-            asm_unary_operand->operand.pseudo.pseudo_name = ir_unary_instr.destination->value.variable.identifier->name;
+            asm_unary_operand->operand.pseudo.vreg = ir_unary_instr.destination->value.variable.vreg;
 
             asm_instruction_unary->instr.unary = (asm_instruction_unary_t){
                 .unary_operator = asm_unary_op,
@@ -719,7 +720,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_mov_first_src->type = OPERAND_PSEUDO;
-                asm_mov_first_src->operand.pseudo.pseudo_name = ir_instruction_binary.left->value.variable.identifier->name;
+                asm_mov_first_src->operand.pseudo.vreg = ir_instruction_binary.left->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -765,7 +766,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_idiv_operand->type = OPERAND_PSEUDO;
-                asm_idiv_operand->operand.pseudo.pseudo_name = ir_instruction_binary.right->value.variable.identifier->name;
+                asm_idiv_operand->operand.pseudo.vreg = ir_instruction_binary.right->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -794,7 +795,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             asm_mov_result_src->operand.reg.reg_no = ASM_REG_RAX;
 
             asm_mov_result_dst->type = OPERAND_PSEUDO;
-            asm_mov_result_dst->operand.pseudo.pseudo_name = ir_instruction_binary.destination->value.variable.identifier->name;
+            asm_mov_result_dst->operand.pseudo.vreg = ir_instruction_binary.destination->value.variable.vreg;
 
             asm_instruction_mov_result->instr.mov = (asm_instruction_mov_t){
                 .src = asm_mov_result_src,
@@ -845,7 +846,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_mov_first_src->type = OPERAND_PSEUDO;
-                asm_mov_first_src->operand.pseudo.pseudo_name = ir_instruction_binary.left->value.variable.identifier->name;
+                asm_mov_first_src->operand.pseudo.vreg = ir_instruction_binary.left->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -891,7 +892,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_idiv_operand->type = OPERAND_PSEUDO;
-                asm_idiv_operand->operand.pseudo.pseudo_name = ir_instruction_binary.right->value.variable.identifier->name;
+                asm_idiv_operand->operand.pseudo.vreg = ir_instruction_binary.right->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -920,7 +921,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             asm_mov_result_src->operand.reg.reg_no = ASM_REG_RDX;
 
             asm_mov_result_dst->type = OPERAND_PSEUDO;
-            asm_mov_result_dst->operand.pseudo.pseudo_name = ir_instruction_binary.destination->value.variable.identifier->name;
+            asm_mov_result_dst->operand.pseudo.vreg = ir_instruction_binary.destination->value.variable.vreg;
 
             asm_instruction_mov_result->instr.mov = (asm_instruction_mov_t){
                 .src = asm_mov_result_src,
@@ -980,7 +981,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 cmp_second->type = OPERAND_PSEUDO;
-                cmp_second->operand.pseudo.pseudo_name = ir_instruction_binary.right->value.variable.identifier->name;
+                cmp_second->operand.pseudo.vreg = ir_instruction_binary.right->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -994,7 +995,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 cmp_first->type = OPERAND_PSEUDO;
-                cmp_first->operand.pseudo.pseudo_name = ir_instruction_binary.left->value.variable.identifier->name;
+                cmp_first->operand.pseudo.vreg = ir_instruction_binary.left->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -1025,7 +1026,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             mov_src->operand.immediate.value = 0;
 
             mov_dst->type = OPERAND_PSEUDO;
-            mov_dst->operand.pseudo.pseudo_name = ir_instruction_binary.destination->value.variable.identifier->name;
+            mov_dst->operand.pseudo.vreg = ir_instruction_binary.destination->value.variable.vreg;
 
             asm_instruction_mov->instr.mov = (asm_instruction_mov_t){
                 .src = mov_src,
@@ -1072,7 +1073,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
             }
 
             setcc_dst->type = OPERAND_PSEUDO;
-            setcc_dst->operand.pseudo.pseudo_name = ir_instruction_binary.destination->value.variable.identifier->name;
+            setcc_dst->operand.pseudo.vreg = ir_instruction_binary.destination->value.variable.vreg;
 
             asm_instruction_setcc->instr.setcc = (asm_instruction_setcc_t){
                 .condition = condition,
@@ -1122,14 +1123,14 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_mov_first_src->type = OPERAND_PSEUDO;
-                asm_mov_first_src->operand.pseudo.pseudo_name = ir_instruction_binary.left->value.variable.identifier->name;
+                asm_mov_first_src->operand.pseudo.vreg = ir_instruction_binary.left->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
             }
 
             asm_mov_first_dst->type = OPERAND_PSEUDO;
-            asm_mov_first_dst->operand.pseudo.pseudo_name = ir_instruction_binary.destination->value.variable.identifier->name;
+            asm_mov_first_dst->operand.pseudo.vreg = ir_instruction_binary.destination->value.variable.vreg;
 
             asm_instruction_mov_first->instr.mov = (asm_instruction_mov_t){
                 .src = asm_mov_first_src,
@@ -1164,7 +1165,7 @@ asm_instruction_struct_t handle_ir_instruction(ir_instruction_t *ir_instruction)
                 break;
             case IR_VAL_VARIABLE:
                 asm_binary_second_operand->type = OPERAND_PSEUDO;
-                asm_binary_second_operand->operand.pseudo.pseudo_name = ir_instruction_binary.right->value.variable.identifier->name;
+                asm_binary_second_operand->operand.pseudo.vreg = ir_instruction_binary.right->value.variable.vreg;
                 break;
             default:
                 return NULL_INSTRUCTION_STRUCT_ASM;
@@ -1231,9 +1232,10 @@ asm_identifier_t *handle_ir_identifier(ir_identifier_t *ir_identifier)
         return NULL;
     }
 
-    char *ir_name = ir_identifier->name;
-    if (!ir_name)
+    symbol_t ir_name = ir_identifier->name;
+    if (ir_name == SYMBOL_NONE)
     {
+        deallocate(asm_identifier);
         return NULL;
     }
 
@@ -1271,23 +1273,12 @@ asm_function_t *handle_ir_function(ir_function_t *ir_function)
     asm_identifier->base.parent = &(asm_function->base);
     asm_function->name = asm_identifier;
 
-    ir_instruction_t **ir_instructions = ir_function->body;
-    if (!ir_instructions)
-    {
-        return NULL;
-    }
-
-    asm_instruction_t **asm_instruction_buffer = (asm_instruction_t **)allocate(MAX_INSTR_NO_IN_FXN * sizeof(asm_instruction_t *));
-    size_t total_asm_instruction_count = 0;
+    instr_list_init(&asm_function->instructions);
+    asm_function->vreg_count = ir_function->vreg_count;
 
-    size_t ir_instruction_count = ir_function->instruction_count;
-    for (size_t counter = 0; counter < ir_instruction_count; counter++)
+    INSTR_LIST_FOR_EACH(ir_link, &ir_function->body)
     {
-        ir_instruction_t *ir_instruction = ir_instructions[counter];
-        if (!ir_instruction)
-        {
-            return NULL;
-        }
+        ir_instruction_t *ir_instruction = INSTR_LIST_ENTRY(ir_link, ir_instruction_t, link);
 
         asm_instruction_struct_t asm_instruction_struct = handle_ir_instruction(ir_instruction);
         asm_instruction_t **asm_instructions = asm_instruction_struct.instructions;
@@ -1302,29 +1293,12 @@ asm_function_t *handle_ir_function(ir_function_t *ir_function)
             }
 
             asm_instruction->base.parent = &(asm_function->base);
+            instr_list_push_back(&asm_function->instructions, &asm_instruction->link);
         }
 
-        for (size_t counter = 0; counter < asm_instruction_count; counter++)
-        {
-            asm_instruction_buffer[total_asm_instruction_count + counter] = asm_instructions[counter];
-        }
-        total_asm_instruction_count += asm_instruction_count;
         deallocate(asm_instructions);
     }
 
-    asm_instruction_t **total_asm_instructions = (asm_instruction_t **)allocate(sizeof(asm_instruction_t *) * total_asm_instruction_count);
-    if (!total_asm_instructions)
-    {
-        return NULL;
-    }
-    for (size_t counter = 0; counter < total_asm_instruction_count; counter++)
-    {
-        total_asm_instructions[counter] = asm_instruction_buffer[counter];
-    }
-    asm_function->instructions = total_asm_instructions;
-    asm_function->instruction_count = total_asm_instruction_count;
-
-    deallocate(asm_instruction_buffer);
     return asm_function;
 }
 
@@ -1362,6 +1336,5 @@ asm_program_t *handle_ir_program(ir_program_t *ir_program)
 }
 
 #undef NULL_INSTRUCTION_STRUCT_ASM
-#undef MAX_INSTR_NO_IN_FXN
 
 #endif /* DFB0D46D_A862_49CB_B2FF_F7679D71B18C */
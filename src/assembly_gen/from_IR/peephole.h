@@ -0,0 +1,360 @@
+#ifndef F7B21D84_6C3A_4E95_8D17_A0E54C9B2F36
+#define F7B21D84_6C3A_4E95_8D17_A0E54C9B2F36
+
+#include "../../ast/assembly/assembly_ast.h"
+#include "../../allocator/allocator.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+bool asm_peephole_pass(asm_program_t *asm_program);
+void asm_peephole_print_stats(FILE *output_file);
+
+/*
+Peephole optimization over the legalized instruction list, run right before emission. A
+window slides over the list and every rule of the table is tried at each position; a rule
+looks at the first one or two instructions of the window and either rewrites them in place
+or unlinks one. After a rewrite the window steps back by one instruction, so a pattern that
+only appears through the rewrite is still seen. Every rule counts how often it fired, the
+compiler prints the counts when built with -DPEEPHOLE_STATS.
+
+R10 and R11 only ever carry a value from one instruction to the next one or two of the same
+fixup, so the rules that drop a load into them check that the register is written again, or
+that control flow is reached, before it is read.
+
+Building with -DNO_OPTIMIZE leaves the instructions as they are.
+*/
+
+typedef struct
+{
+    const char *name;
+    uint32_t window; // instructions the rule needs, starting at the current one
+    bool (*apply)(instr_list_t *list, asm_instruction_t **window);
+    size_t fired;
+} asm_peephole_rule_t;
+
+static bool asm_operand_equal(const asm_operand_t *first, const asm_operand_t *second)
+{
+    if (first->type != second->type)
+    {
+        return false;
+    }
+
+    switch (first->type)
+    {
+    case OPERAND_IMMEDIATE:
+        return first->operand.immediate.value == second->operand.immediate.value;
+    case OPERAND_REGISTER:
+        return first->operand.reg.reg_no == second->operand.reg.reg_no;
+    case OPERAND_PSEUDO:
+        return first->operand.pseudo.vreg == second->operand.pseudo.vreg;
+    case OPERAND_STACK:
+        return first->operand.stack.offset == second->operand.stack.offset;
+    }
+    return false;
+}
+
+static bool asm_operand_is_register(const asm_operand_t *operand, asm_reg_no_t reg_no)
+{
+    return operand && operand->type == OPERAND_REGISTER && operand->operand.reg.reg_no == reg_no;
+}
+
+static bool asm_operand_is_zero(const asm_operand_t *operand)
+{
+    return operand->type == OPERAND_IMMEDIATE && operand->operand.immediate.value == 0;
+}
+
+// Whether instruction reads reg through one of its explicit operands
+static bool asm_instruction_reads(const asm_instruction_t *instruction, asm_reg_no_t reg_no)
+{
+    switch (instruction->type)
+    {
+    case INSTRUCTION_MOV:
+        return asm_operand_is_register(instruction->instr.mov.src, reg_no);
+    case INSTRUCTION_UNARY:
+        return asm_operand_is_register(instruction->instr.unary.operand, reg_no);
+    case INSTRUCTION_BINARY:
+        return asm_operand_is_register(instruction->instr.binary.first_operand, reg_no) ||
+               asm_operand_is_register(instruction->instr.binary.second_operand, reg_no);
+    case INSTRUCTION_IDIV:
+        return asm_operand_is_register(instruction->instr.idiv.operand, reg_no);
+    case INSTRUCTION_CMP:
+        return asm_operand_is_register(instruction->instr.cmp.first_operand, reg_no) ||
+               asm_operand_is_register(instruction->instr.cmp.second_operand, reg_no);
+    case INSTRUCTION_TEST:
+        return asm_operand_is_register(instruction->instr.test.first_operand, reg_no) ||
+               asm_operand_is_register(instruction->instr.test.second_operand, reg_no);
+    case INSTRUCTION_SETCC:
+        // setcc only writes the low byte, the rest of the register survives
+        return asm_operand_is_register(instruction->instr.setcc.dst, reg_no);
+    default:
+        return false;
+    }
+}
+
+// Whether the scratch register reg holds nothing of interest once link is reached
+static bool asm_scratch_dead_from(instr_list_t *list, instr_link_t *link, asm_reg_no_t reg_no)
+{
+    for (; link; link = instr_list_next(list, link))
+    {
+        asm_instruction_t *instruction = INSTR_LIST_ENTRY(link, asm_instruction_t, link);
+        if (asm_instruction_reads(instruction, reg_no))
+        {
+            return false;
+        }
+
+        switch (instruction->type)
+        {
+        case INSTRUCTION_MOV:
+            if (asm_operand_is_register(instruction->instr.mov.dst, reg_no))
+            {
+                return true;
+            }
+            break;
+        case INSTRUCTION_JMP:
+        case INSTRUCTION_JMPCC:
+        case INSTRUCTION_LABEL:
+        case INSTRUCTION_RET:
+            return true;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+static bool asm_is_mov(const asm_instruction_t *instruction)
+{
+    return instruction->type == INSTRUCTION_MOV;
+}
+
+// mov x, x
+static bool asm_peephole_self_move(instr_list_t *list, asm_instruction_t **window)
+{
+    if (!asm_is_mov(window[0]) || !asm_operand_equal(window[0]->instr.mov.src, window[0]->instr.mov.dst))
+    {
+        return false;
+    }
+
+    instr_list_remove(list, &window[0]->link);
+    return true;
+}
+
+// sub rsp, 0 when the function needs no stack slots
+static bool asm_peephole_empty_stack_allocation(instr_list_t *list, asm_instruction_t **window)
+{
+    if (window[0]->type != INSTRUCTION_ALLOCATE_STACK || window[0]->instr.alloc_stack.alloc_size != 0)
+    {
+        return false;
+    }
+
+    instr_list_remove(list, &window[0]->link);
+    return true;
+}
+
+// mov [s], x; mov r, [s] becomes mov [s], x; mov r, x
+static bool asm_peephole_store_reload(instr_list_t *list, asm_instruction_t **window)
+{
+    (void)list;
+    if (!asm_is_mov(window[0]) || !asm_is_mov(window[1]))
+    {
+        return false;
+    }
+
+    asm_instruction_mov_t *store = &window[0]->instr.mov;
+    asm_instruction_mov_t *load = &window[1]->instr.mov;
+    if (store->dst->type != OPERAND_STACK || store->src->type == OPERAND_STACK || load->dst->type != OPERAND_REGISTER ||
+        !asm_operand_equal(store->dst, load->src))
+    {
+        return false;
+    }
+
+    // when x is r itself the load turns into mov r, r and the next round drops it
+    load->src = store->src;
+    return true;
+}
+
+// mov r10d, a; mov b, r10d becomes mov b, a while r10d is not needed afterwards
+static bool asm_peephole_move_chain(instr_list_t *list, asm_instruction_t **window)
+{
+    if (!asm_is_mov(window[0]) || !asm_is_mov(window[1]))
+    {
+        return false;
+    }
+
+    asm_instruction_mov_t *first = &window[0]->instr.mov;
+    asm_instruction_mov_t *second = &window[1]->instr.mov;
+    if (first->dst->type != OPERAND_REGISTER || !asm_operand_equal(first->dst, second->src) ||
+        (first->src->type == OPERAND_STACK && second->dst->type == OPERAND_STACK))
+    {
+        return false;
+    }
+
+    asm_reg_no_t reg_no = first->dst->operand.reg.reg_no;
+    if ((reg_no != ASM_REG_R10 && reg_no != ASM_REG_R11) ||
+        !asm_scratch_dead_from(list, instr_list_next(list, &window[1]->link), reg_no))
+    {
+        return false;
+    }
+
+    second->src = first->src;
+    instr_list_remove(list, &window[0]->link);
+    return true;
+}
+
+// add x, 0 and the other operations that leave x as it is; the flags are never read after them
+static bool asm_peephole_identity(instr_list_t *list, asm_instruction_t **window)
+{
+    if (window[0]->type != INSTRUCTION_BINARY)
+    {
+        return false;
+    }
+
+    const asm_operand_t *operand = window[0]->instr.binary.second_operand;
+    if (operand->type != OPERAND_IMMEDIATE)
+    {
+        return false;
+    }
+
+    switch (window[0]->instr.binary.binary_operator->binary_op)
+    {
+    case ASM_BINARY_ADD:
+    case ASM_BINARY_SUB:
+    case ASM_BINARY_BITWISE_OR:
+    case ASM_BINARY_BITWISE_XOR:
+    case ASM_BINARY_BITWISE_SHIFT_LEFT:
+    case ASM_BINARY_BITWISE_SHIFT_RIGHT:
+        if (operand->operand.immediate.value != 0)
+        {
+            return false;
+        }
+        break;
+    case ASM_BINARY_MULT:
+        if (operand->operand.immediate.value != 1)
+        {
+            return false;
+        }
+        break;
+    case ASM_BINARY_BITWISE_AND:
+        if (operand->operand.immediate.value != -1)
+        {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    instr_list_remove(list, &window[0]->link);
+    return true;
+}
+
+// cmp r, 0 becomes test r, r
+static bool asm_peephole_compare_zero(instr_list_t *list, asm_instruction_t **window)
+{
+    (void)list;
+    asm_instruction_cmp_t *cmp = &window[0]->instr.cmp;
+    if (window[0]->type != INSTRUCTION_CMP || cmp->first_operand->type != OPERAND_REGISTER ||
+        !asm_operand_is_zero(cmp->second_operand))
+    {
+        return false;
+    }
+
+    asm_operand_t *reg_operand = cmp->first_operand;
+    window[0]->type = INSTRUCTION_TEST;
+    window[0]->instr.test.first_operand = reg_operand;
+    window[0]->instr.test.second_operand = reg_operand;
+    return true;
+}
+
+// mov [s], r; cmp [s], 0 compares the register instead, which the rule above then turns into a test
+static bool asm_peephole_compare_stored(instr_list_t *list, asm_instruction_t **window)
+{
+    (void)list;
+    if (!asm_is_mov(window[0]) || window[1]->type != INSTRUCTION_CMP)
+    {
+        return false;
+    }
+
+    asm_instruction_mov_t *store = &window[0]->instr.mov;
+    asm_instruction_cmp_t *cmp = &window[1]->instr.cmp;
+    if (store->dst->type != OPERAND_STACK || store->src->type != OPERAND_REGISTER ||
+        !asm_operand_equal(store->dst, cmp->first_operand) || !asm_operand_is_zero(cmp->second_operand))
+    {
+        return false;
+    }
+
+    cmp->first_operand = store->src;
+    return true;
+}
+
+static asm_peephole_rule_t asm_peephole_rules[] = {
+    {.name = "self move", .window = 1, .apply = asm_peephole_self_move},
+    {.name = "empty stack allocation", .window = 1, .apply = asm_peephole_empty_stack_allocation},
+    {.name = "store reload", .window = 2, .apply = asm_peephole_store_reload},
+    {.name = "move chain", .window = 2, .apply = asm_peephole_move_chain},
+    {.name = "identity operation", .window = 1, .apply = asm_peephole_identity},
+    {.name = "compare stored", .window = 2, .apply = asm_peephole_compare_stored},
+    {.name = "compare zero", .window = 1, .apply = asm_peephole_compare_zero},
+};
+
+#define ASM_PEEPHOLE_RULE_COUNT (sizeof(asm_peephole_rules) / sizeof(asm_peephole_rules[0]))
+#define ASM_PEEPHOLE_MAX_WINDOW 2
+
+bool asm_peephole_pass(asm_program_t *asm_program)
+{
+    if (!asm_program || !asm_program->function)
+    {
+        return false;
+    }
+
+#ifdef NO_OPTIMIZE
+    return true;
+#else
+    instr_list_t *list = &asm_program->function->instructions;
+    instr_link_t *link = instr_list_first(list);
+    while (link)
+    {
+        asm_instruction_t *window[ASM_PEEPHOLE_MAX_WINDOW];
+        uint32_t available = 0;
+        for (instr_link_t *cursor = link; cursor && available < ASM_PEEPHOLE_MAX_WINDOW;
+             cursor = instr_list_next(list, cursor))
+        {
+            window[available++] = INSTR_LIST_ENTRY(cursor, asm_instruction_t, link);
+        }
+
+        // the instruction before the window is left alone by every rule, so it is a safe place to resume
+        instr_link_t *previous = instr_list_prev(list, link);
+        bool fired = false;
+        for (size_t i = 0; i < ASM_PEEPHOLE_RULE_COUNT && !fired; i++)
+        {
+            asm_peephole_rule_t *rule = &asm_peephole_rules[i];
+            if (rule->window <= available && rule->apply(list, window))
+            {
+                rule->fired++;
+                fired = true;
+            }
+        }
+
+        if (!fired)
+        {
+            link = instr_list_next(list, link);
+        }
+        else
+        {
+            link = previous ? previous : instr_list_first(list);
+        }
+    }
+    return true;
+#endif
+}
+
+void asm_peephole_print_stats(FILE *output_file)
+{
+    fprintf(output_file, "peephole rules fired:\n");
+    for (size_t i = 0; i < ASM_PEEPHOLE_RULE_COUNT; i++)
+    {
+        fprintf(output_file, "  %-20s %zu\n", asm_peephole_rules[i].name, asm_peephole_rules[i].fired);
+    }
+}
+
+#endif /* F7B21D84_6C3A_4E95_8D17_A0E54C9B2F36 */
@@ -1,13 +1,21 @@
 #ifndef EB43219C_096E_4B3E_85A7_6E422D557509
 #define EB43219C_096E_4B3E_85A7_6E422D557509
 
+#include <string.h>
 #include "../../ast/assembly/assembly_ast.h"
-#include "../../hash_table/hash_table.h"
+#include "../../allocator/allocator.h"
+
+// Stack offset of every virtual register, 0 until the register is first seen
+typedef struct
+{
+    int *offsets;
+    uint32_t count;
+} stack_slots_t;
 
 bool asm_second_pass(asm_program_t *asm_program, int *final_offset);
 bool replace_pseudoregisters(asm_program_t *asm_program);
 static int create_new_offset(void);
-bool replace_pseudoregs_operand(asm_operand_t *asm_operand, hash_table_t *hash_table);
+bool replace_pseudoregs_operand(asm_operand_t *asm_operand, stack_slots_t *stack_slots);
 
 bool asm_second_pass(asm_program_t *asm_program, int *final_offset)
 {
@@ -20,7 +28,7 @@ bool asm_second_pass(asm_program_t *asm_program, int *final_offset)
     return true;
 }
 
-bool replace_pseudoregs_operand(asm_operand_t *asm_operand, hash_table_t *hash_table)
+bool replace_pseudoregs_operand(asm_operand_t *asm_operand, stack_slots_t *stack_slots)
 {
     if (!asm_operand)
     {
@@ -35,19 +43,20 @@ bool replace_pseudoregs_operand(asm_operand_t *asm_operand, hash_table_t *hash_t
 
     if (*asm_operand_type == OPERAND_PSEUDO)
     {
-        *asm_operand_type = OPERAND_STACK;
-        const char *identifier = asm_operand->operand.pseudo.pseudo_name;
-        hash_node_t *node = hash_table_search(hash_table, identifier);
-        if (!node)
+        uint32_t vreg = asm_operand->operand.pseudo.vreg;
+        if (vreg >= stack_slots->count)
         {
-            int offset = create_new_offset();
-            asm_operand->operand.stack = (asm_stack_t){.offset = offset};
-            hash_table_insert(hash_table, identifier, offset);
+            return false;
         }
-        else
+
+        int *offset = &stack_slots->offsets[vreg];
+        if (!*offset)
         {
-            asm_operand->operand.stack = (asm_stack_t){.offset = node->offset};
+            *offset = create_new_offset();
         }
+
+        *asm_operand_type = OPERAND_STACK;
+        asm_operand->operand.stack = (asm_stack_t){.offset = *offset};
     }
 
     return true;
@@ -67,34 +76,24 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
         return false;
     }
 
-    hash_table_t *hash_table = create_hash_table();
-    if (!hash_table)
-    {
-        return false;
-    }
-
     asm_function_t *asm_function = asm_program->function;
     if (!asm_function)
     {
-        destroy_hash_table(hash_table);
         return false;
     }
-    asm_instruction_t **asm_instructions = asm_function->instructions;
-    if (!asm_instructions)
+
+    size_t slots_size = (asm_function->vreg_count ? asm_function->vreg_count : 1) * sizeof(int);
+    stack_slots_t stack_slots_storage = {.offsets = (int *)allocate(slots_size), .count = asm_function->vreg_count};
+    stack_slots_t *stack_slots = &stack_slots_storage;
+    if (!stack_slots->offsets)
     {
-        destroy_hash_table(hash_table);
         return false;
     }
-    size_t asm_instruction_count = asm_function->instruction_count;
+    memset(stack_slots->offsets, 0, slots_size);
 
-    for (size_t counter = 0; counter < asm_instruction_count; counter++)
+    INSTR_LIST_FOR_EACH(link, &asm_function->instructions)
     {
-        asm_instruction_t *asm_instruction = asm_instructions[counter];
-        if (!asm_instruction)
-        {
-            destroy_hash_table(hash_table);
-            return false;
-        }
+        asm_instruction_t *asm_instruction = INSTR_LIST_ENTRY(link, asm_instruction_t, link);
 
         asm_instruction_type_t asm_instruction_type = asm_instruction->type;
 
@@ -105,19 +104,19 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_unary_t *asm_instruction_unary = &asm_instruction->instr.unary;
             if (!asm_instruction_unary)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             asm_operand_t *asm_unary_operand = asm_instruction_unary->operand;
             if (!asm_unary_operand)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(asm_unary_operand, hash_table))
+            if (!replace_pseudoregs_operand(asm_unary_operand, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break;
@@ -127,26 +126,26 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_mov_t *asm_instruction_mov = &asm_instruction->instr.mov;
             if (!asm_instruction_mov)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             asm_operand_t *asm_mov_src = asm_instruction_mov->src;
             if (!asm_mov_src)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             asm_operand_t *asm_mov_dst = asm_instruction_mov->dst;
             if (!asm_mov_dst)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(asm_mov_dst, hash_table) ||
-                !replace_pseudoregs_operand(asm_mov_src, hash_table))
+            if (!replace_pseudoregs_operand(asm_mov_dst, stack_slots) ||
+                !replace_pseudoregs_operand(asm_mov_src, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break;
@@ -156,26 +155,26 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_binary_t *asm_instruction_binary = &asm_instruction->instr.binary;
             if (!asm_instruction_binary)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             asm_operand_t *asm_binary_first = asm_instruction_binary->first_operand;
             if (!asm_binary_first)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             asm_operand_t *asm_binary_second = asm_instruction_binary->second_operand;
             if (!asm_binary_second)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(asm_binary_first, hash_table) ||
-                !replace_pseudoregs_operand(asm_binary_second, hash_table))
+            if (!replace_pseudoregs_operand(asm_binary_first, stack_slots) ||
+                !replace_pseudoregs_operand(asm_binary_second, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break;
@@ -185,7 +184,7 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_cmp_t *asm_instruction_cmp = &asm_instruction->instr.cmp;
             if (!asm_instruction_cmp)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
@@ -194,14 +193,14 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
 
             if (!first_operand || !second_operand)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(first_operand, hash_table) ||
-                !replace_pseudoregs_operand(second_operand, hash_table))
+            if (!replace_pseudoregs_operand(first_operand, stack_slots) ||
+                !replace_pseudoregs_operand(second_operand, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break;
@@ -211,20 +210,20 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_setcc_t *asm_instruction_setcc = &asm_instruction->instr.setcc;
             if (!asm_instruction_setcc)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
             asm_operand_t *dest = asm_instruction_setcc->dst;
             if (!dest)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(dest, hash_table))
+            if (!replace_pseudoregs_operand(dest, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break;
@@ -234,28 +233,31 @@ bool replace_pseudoregisters(asm_program_t *asm_program)
             asm_instruction_idiv_t *asm_instruction_idiv = &asm_instruction->instr.idiv;
             if (!asm_instruction_idiv)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
             asm_operand_t *operand_idiv = asm_instruction_idiv->operand;
             if (!operand_idiv)
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
 
-            if (!replace_pseudoregs_operand(operand_idiv, hash_table))
+            if (!replace_pseudoregs_operand(operand_idiv, stack_slots))
             {
-                destroy_hash_table(hash_table);
+                deallocate(stack_slots->offsets);
                 return false;
             }
             break; // Added missing break statement
         }
+        case INSTRUCTION_TEST:
+            // only the peephole pass produces it, once every pseudoregister is gone
+            break;
         }
     }
 
-    destroy_hash_table(hash_table); // Added cleanup for success path
+    deallocate(stack_slots->offsets);
     return true;
 }
 
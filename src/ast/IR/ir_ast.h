@@ -2,6 +2,9 @@
 #define F68732A3_D9B4_483E_A152_AB2FB4E19B12
 
 #include <stdlib.h>
+#include <stdint.h>
+#include "../../string_container/string_interner.h"
+#include "../../instr_list/instr_list.h"
 
 typedef enum
 {
@@ -36,12 +39,14 @@ typedef struct ir_unary_operator_e
 typedef struct ir_identifier_e
 {
     ir_ast_node_t base;
-    char *name;
+    symbol_t name;
 } ir_identifier_t;
 
+// Temporaries and resolved locals are numbered 0..vreg_count-1 within their function
 typedef struct ir_variable_e
 {
-    ir_identifier_t *identifier;
+    uint32_t vreg;
+    symbol_t name; // source name of a local, SYMBOL_NONE for temporaries
 } ir_variable_t;
 
 typedef enum
@@ -141,6 +146,7 @@ typedef enum
     IR_INSTR_JUMP_IF_ZERO,
     IR_INSTR_JUMP_IF_NOT_ZERO,
     IR_INSTR_LABEL,
+    IR_INSTR_PHI,
 } ir_instruction_type_t;
 
 typedef struct
@@ -155,9 +161,19 @@ typedef struct
     ir_value_t *destination;
 } ir_instruction_unary_t;
 
+// Only exists in SSA form, while the function is held in a control-flow graph
+typedef struct
+{
+    ir_value_t *destination;
+    ir_value_t **arguments; // arguments[i] is the value flowing in from block predecessors[i]
+    uint32_t *predecessors;
+    uint32_t argument_count;
+} ir_instruction_phi_t;
+
 typedef struct ir_instruction_e
 {
     ir_ast_node_t base;
+    instr_link_t link;
     ir_instruction_type_t type;
     union
     {
@@ -169,6 +185,7 @@ typedef struct ir_instruction_e
         ir_instruction_jz_t jz_instr;
         ir_instruction_jnz_t jnz_instr;
         ir_instruction_label_t label_instr;
+        ir_instruction_phi_t phi_instr;
     } instruction;
 } ir_instruction_t;
 
@@ -176,8 +193,8 @@ typedef struct
 {
     ir_ast_node_t base;
     ir_identifier_t *name;
-    ir_instruction_t **body;
-    size_t instruction_count;
+    instr_list_t body;
+    uint32_t vreg_count;
 } ir_function_t;
 
 typedef struct
@@ -186,10 +203,4 @@ typedef struct
     ir_function_t *function;
 } ir_program_t;
 
-typedef struct
-{
-    ir_instruction_t **instructions;
-    size_t instruction_count;
-} ir_instruction_struct_t;
-
 #endif /* F68732A3_D9B4_483E_A152_AB2FB4E19B12 */
\ No newline at end of file
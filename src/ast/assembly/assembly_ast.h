@@ -2,6 +2,8 @@
 #define D36C472B_CEDF_4E5E_B6E9_DDAE1DEA3523
 
 #include <stdlib.h>
+#include "../../string_container/string_interner.h"
+#include "../../instr_list/instr_list.h"
 
 typedef struct asm_program_ asm_program_t;
 typedef struct asm_function_ asm_function_t;
@@ -24,6 +26,7 @@ typedef struct asm_instruction_idiv_ asm_instruction_idiv_t;
 typedef struct asm_instruction_cqo_ asm_instruction_cqo_t;
 
 typedef struct asm_instruction_cmp_ asm_instruction_cmp_t;
+typedef struct asm_instruction_test_ asm_instruction_test_t;
 typedef struct asm_instruction_jmp_ asm_instruction_jmp_t;
 typedef struct asm_instruction_jmpcc_ asm_instruction_jmpcc_t;
 typedef struct asm_instruction_setcc_ asm_instruction_setcc_t;
@@ -66,6 +69,7 @@ typedef enum
     INSTRUCTION_JMPCC,
     INSTRUCTION_SETCC,
     INSTRUCTION_LABEL,
+    INSTRUCTION_TEST,
 } asm_instruction_type_t;
 
 // New enum for condition codes
@@ -100,7 +104,7 @@ struct asm_register_
 
 struct asm_pseudo_
 {
-    char *pseudo_name;
+    uint32_t vreg;
 };
 
 struct asm_stack_
@@ -111,7 +115,7 @@ struct asm_stack_
 struct asm_identifier_
 {
     asm_ast_node_t base;
-    char *name;
+    symbol_t name;
 };
 
 struct asm_operand_
@@ -198,6 +202,13 @@ struct asm_instruction_cmp_
     asm_operand_t *second_operand;
 };
 
+// Only produced by the peephole pass, in place of a compare against zero
+struct asm_instruction_test_
+{
+    asm_operand_t *first_operand;
+    asm_operand_t *second_operand;
+};
+
 struct asm_instruction_jmp_
 {
     asm_identifier_t *target;
@@ -224,6 +235,7 @@ struct asm_instruction_label_
 struct asm_instruction_
 {
     asm_ast_node_t base;
+    instr_link_t link;
     asm_instruction_type_t type;
     union
     {
@@ -239,6 +251,7 @@ struct asm_instruction_
         asm_instruction_jmpcc_t jmpcc;
         asm_instruction_setcc_t setcc;
         asm_instruction_label_t label;
+        asm_instruction_test_t test;
     } instr;
 };
 
@@ -246,8 +259,8 @@ struct asm_function_
 {
     asm_ast_node_t base;
     asm_identifier_t *name;
-    asm_instruction_t **instructions;
-    size_t instruction_count;
+    instr_list_t instructions;
+    uint32_t vreg_count;
 };
 
 struct asm_program_
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include "../../string_container/string_interner.h"
 
 typedef struct ast_node_t ast_node_t;
 typedef struct function_def_t function_def_t;
@@ -96,7 +97,7 @@ struct unary_t
 struct identifier_t
 {
     ast_node_t base;
-    char *name;
+    symbol_t name;
 };
 
 /**
@@ -28,6 +28,13 @@ const char *map_register_name(int reg)
     return "";
 }
 
+// Pseudos are normally all on the stack by now, this only shows up in dumps of earlier passes
+const char *format_pseudo(uint32_t vreg, char *buffer, size_t size)
+{
+    snprintf(buffer, size, "%%%u", vreg);
+    return buffer;
+}
+
 FILE *create_output_file(const char *name)
 {
     FILE *output_file = fopen(name, "w");
@@ -94,7 +101,7 @@ bool emit_function_prologue(asm_function_t *function, FILE *output_file)
     }
 
     if (fprintf(output_file, "global %s\n%s:\n",
-                function->name->name, function->name->name) < 0)
+                symbol_name(function->name->name), symbol_name(function->name->name)) < 0)
     {
         fprintf(stderr, "Error writing function name\n");
         return false;
@@ -155,7 +162,7 @@ bool emit_mov_instruction(asm_instruction_t *instruction, FILE *output_file)
         dst_str = map_register_name(dst->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        dst_str = dst->operand.pseudo.pseudo_name;
+        dst_str = format_pseudo(dst->operand.pseudo.vreg, stack_dst_buf, sizeof(stack_dst_buf));
         break;
     case OPERAND_STACK:
         snprintf(stack_dst_buf, sizeof(stack_dst_buf), "[rbp-%d]",
@@ -180,7 +187,7 @@ bool emit_mov_instruction(asm_instruction_t *instruction, FILE *output_file)
         src_str = imm_buf;
         break;
     case OPERAND_PSEUDO:
-        src_str = src->operand.pseudo.pseudo_name;
+        src_str = format_pseudo(src->operand.pseudo.vreg, stack_src_buf, sizeof(stack_src_buf));
         break;
     case OPERAND_STACK:
         snprintf(stack_src_buf, sizeof(stack_src_buf), "[rbp-%d]",
@@ -261,7 +268,7 @@ bool emit_unary_instruction(asm_instruction_t *instruction, FILE *output_file)
         operand_str = map_register_name(operand->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        operand_str = operand->operand.pseudo.pseudo_name;
+        operand_str = format_pseudo(operand->operand.pseudo.vreg, stack_buf, sizeof(stack_buf));
         break;
     case OPERAND_STACK:
         snprintf(stack_buf, sizeof(stack_buf), "[rbp-%d]",
@@ -357,7 +364,7 @@ bool emit_binary_instruction(asm_instruction_t *asm_instruction, FILE *output_fi
         first_str = map_register_name(first_operand->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        first_str = first_operand->operand.pseudo.pseudo_name;
+        first_str = format_pseudo(first_operand->operand.pseudo.vreg, first_buf, sizeof(first_buf));
         break;
     case OPERAND_STACK:
         snprintf(first_buf, sizeof(first_buf), "[rbp-%d]", -first_operand->operand.stack.offset);
@@ -375,7 +382,7 @@ bool emit_binary_instruction(asm_instruction_t *asm_instruction, FILE *output_fi
         second_str = map_register_name(second_operand->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        second_str = second_operand->operand.pseudo.pseudo_name;
+        second_str = format_pseudo(second_operand->operand.pseudo.vreg, second_buf, sizeof(second_buf));
         break;
     case OPERAND_STACK:
         snprintf(second_buf, sizeof(second_buf), "[rbp-%d]", -second_operand->operand.stack.offset);
@@ -389,9 +396,12 @@ bool emit_binary_instruction(asm_instruction_t *asm_instruction, FILE *output_fi
 
     if (op == ASM_BINARY_BITWISE_SHIFT_LEFT || op == ASM_BINARY_BITWISE_SHIFT_RIGHT)
     {
+        // a variable shift count always lives in cl, a constant one is encoded directly
+        const char *count_str = second_operand->type == OPERAND_IMMEDIATE ? second_str : "cl";
+
         if (first_operand->type == OPERAND_STACK)
         {
-            if (fprintf(output_file, "    %s dword %s, cl\n", op_str, first_str) < 0)
+            if (fprintf(output_file, "    %s dword %s, %s\n", op_str, first_str, count_str) < 0)
             {
                 fprintf(stderr, "Error writing binary instruction\n");
                 return false;
@@ -399,7 +409,7 @@ bool emit_binary_instruction(asm_instruction_t *asm_instruction, FILE *output_fi
         }
         else
         {
-            if (fprintf(output_file, "    %s %s, cl\n", op_str, first_str) < 0)
+            if (fprintf(output_file, "    %s %s, %s\n", op_str, first_str, count_str) < 0)
             {
                 fprintf(stderr, "Error writing binary instruction\n");
                 return false;
@@ -450,7 +460,8 @@ bool emit_cqo_instruction(asm_instruction_t *asm_instruction, FILE *output_file)
         return false;
     }
 
-    fprintf(output_file, "    cqo\n");
+    // operands are 32 bit, so the dividend is sign extended from eax into edx rather than rax into rdx
+    fprintf(output_file, "    cdq\n");
 
     return true;
 }
@@ -541,7 +552,7 @@ bool emit_jmp_instruction(asm_instruction_t *instruction, FILE *output_file)
         return false;
     }
 
-    if (fprintf(output_file, "    jmp %s\n", instruction->instr.jmp.target->name) < 0)
+    if (fprintf(output_file, "    jmp %s\n", symbol_name(instruction->instr.jmp.target->name)) < 0)
     {
         fprintf(stderr, "Error writing unconditional jump instructions\n");
         return false;
@@ -568,7 +579,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     {
     case COND_E:
     {
-        if (fprintf(output_file, "    je %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    je %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -578,7 +589,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     case COND_NE:
     {
 
-        if (fprintf(output_file, "    jne %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    jne %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -587,7 +598,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     }
     case COND_G:
     {
-        if (fprintf(output_file, "    jg %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    jg %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -596,7 +607,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     }
     case COND_GE:
     {
-        if (fprintf(output_file, "    jge %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    jge %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -605,7 +616,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     }
     case COND_L:
     {
-        if (fprintf(output_file, "    jl %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    jl %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -614,7 +625,7 @@ bool emit_jmpcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     }
     case COND_LE:
     {
-        if (fprintf(output_file, "    jle %s\n", instruction->instr.jmpcc.target->name) < 0)
+        if (fprintf(output_file, "    jle %s\n", symbol_name(instruction->instr.jmpcc.target->name)) < 0)
         {
             fprintf(stderr, "Error writing unconditional jump instructions\n");
             return false;
@@ -660,7 +671,7 @@ bool emit_cmp_instruction(asm_instruction_t *instruction, FILE *output_file)
         first_str = map_register_name(first_operand->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        first_str = first_operand->operand.pseudo.pseudo_name;
+        first_str = format_pseudo(first_operand->operand.pseudo.vreg, first_buf, sizeof(first_buf));
         break;
     case OPERAND_STACK:
         snprintf(first_buf, sizeof(first_buf), "[rbp-%d]", -first_operand->operand.stack.offset);
@@ -678,7 +689,7 @@ bool emit_cmp_instruction(asm_instruction_t *instruction, FILE *output_file)
         second_str = map_register_name(second_operand->operand.reg.reg_no);
         break;
     case OPERAND_PSEUDO:
-        second_str = second_operand->operand.pseudo.pseudo_name;
+        second_str = format_pseudo(second_operand->operand.pseudo.vreg, second_buf, sizeof(second_buf));
         break;
     case OPERAND_STACK:
         snprintf(second_buf, sizeof(second_buf), "[rbp-%d]", -second_operand->operand.stack.offset);
@@ -718,6 +729,33 @@ bool emit_cmp_instruction(asm_instruction_t *instruction, FILE *output_file)
     return true;
 }
 
+bool emit_test_instruction(asm_instruction_t *instruction, FILE *output_file)
+{
+    if (!instruction || !output_file)
+    {
+        fprintf(stderr, "Error: NULL instruction or output file in emit_test_instruction\n");
+        return false;
+    }
+
+    asm_instruction_test_t *test_instruction = &instruction->instr.test;
+    if (!test_instruction->first_operand || !test_instruction->second_operand ||
+        test_instruction->first_operand->type != OPERAND_REGISTER ||
+        test_instruction->second_operand->type != OPERAND_REGISTER)
+    {
+        fprintf(stderr, "Error: test instruction needs register operands\n");
+        return false;
+    }
+
+    if (fprintf(output_file, "    test %s, %s\n", map_register_name(test_instruction->first_operand->operand.reg.reg_no),
+                map_register_name(test_instruction->second_operand->operand.reg.reg_no)) < 0)
+    {
+        fprintf(stderr, "Error writing test instruction\n");
+        return false;
+    }
+
+    return true;
+}
+
 bool emit_setcc_instruction(asm_instruction_t *instruction, FILE *output_file)
 {
     if (!instruction || !output_file)
@@ -727,7 +765,7 @@ bool emit_setcc_instruction(asm_instruction_t *instruction, FILE *output_file)
     }
 
     asm_instruction_setcc_t *setcc_instruction = &instruction->instr.setcc;
-    if (!setcc_instruction->condition || !setcc_instruction->dst)
+    if (!setcc_instruction->dst)
     {
         fprintf(stderr, "Error: Incomplete setcc instruction\n");
         return false;
@@ -789,7 +827,7 @@ bool emit_setcc_instruction(asm_instruction_t *instruction, FILE *output_file)
         }
         break;
     case OPERAND_PSEUDO:
-        dest_str = dest_operand->operand.pseudo.pseudo_name;
+        dest_str = format_pseudo(dest_operand->operand.pseudo.vreg, dest_buf, sizeof(dest_buf));
         break;
     case OPERAND_STACK:
         snprintf(dest_buf, sizeof(dest_buf), "byte [rbp-%d]", -dest_operand->operand.stack.offset);
@@ -819,7 +857,7 @@ bool emit_label_instruction(asm_instruction_t *instruction, FILE *output_file)
 
     asm_instruction_label_t label = instruction->instr.label;
 
-    if (fprintf(output_file, "%s:\n", label.label->name) < 0)
+    if (fprintf(output_file, "%s:\n", symbol_name(label.label->name)) < 0)
     {
         fprintf(stderr, "Error writing label instruction\n");
         return false;
@@ -864,6 +902,8 @@ bool emit_asm_instruction(asm_instruction_t *instruction, FILE *output_file)
         return emit_jmpcc_instruction(instruction, output_file);
     case INSTRUCTION_CMP:
         return emit_cmp_instruction(instruction, output_file);
+    case INSTRUCTION_TEST:
+        return emit_test_instruction(instruction, output_file);
     case INSTRUCTION_SETCC:
         return emit_setcc_instruction(instruction, output_file);
     case INSTRUCTION_LABEL:
@@ -893,19 +933,16 @@ bool emit_asm_function(asm_function_t *function, FILE *output_file)
         return false;
     }
 
-    for (size_t i = 0; i < function->instruction_count; i++)
+    size_t i = 0;
+    INSTR_LIST_FOR_EACH(link, &function->instructions)
     {
-        if (!function->instructions[i])
-        {
-            fprintf(stderr, "Error: NULL instruction at index %zu\n", i);
-            return false;
-        }
-
-        if (!emit_asm_instruction(function->instructions[i], output_file))
+        asm_instruction_t *instruction = INSTR_LIST_ENTRY(link, asm_instruction_t, link);
+        if (!emit_asm_instruction(instruction, output_file))
         {
             fprintf(stderr, "Error: Failed to emit instruction at index %zu\n", i);
             return false;
         }
+        i++;
     }
 
     return true;
@@ -3,9 +3,11 @@
 #include <string.h>
 #include "./code_emitter/code_emitter.h"
 #include "./ir_gen/ir_generation.h"
+#include "./optimizer/optimizer.h"
 #include "./assembly_gen/from_IR/first_pass.h"
 #include "./assembly_gen/from_IR/second_pass.h"
 #include "./assembly_gen/from_IR/third_pass.h"
+#include "./assembly_gen/from_IR/peephole.h"
 #include "./parser/parser.h"
 #include "./semantic_analyzer/variable_resolution.h"
 
@@ -18,9 +20,28 @@ constant expressions at compile time is simpler than evaluating only some.
 
 */
 
+/*
+Nodes are allocated from one arena per phase. Building with -DCUSTOM_ALLOCATOR sends them
+to the pooled allocator instead, which is how the pool is benchmarked against malloc
+(-DSYSTEM_ALLOCATOR).
+*/
+
+// Building with -DDUMP_IR prints the control-flow graph of the optimized IR to stderr
+
+// Building with -DPEEPHOLE_STATS prints how often each peephole rule fired to stderr
+
+static void enter_phase(arena_t *arena)
+{
+#if defined(CUSTOM_ALLOCATOR) || defined(SYSTEM_ALLOCATOR)
+    (void)arena;
+#else
+    change_allocator_to_arena(arena);
+#endif
+}
+
 void print_usage(const char *prog_name)
 {
-    fprintf(stderr, "Usage: %s <inputfile> [-o <outputfile>]\n", prog_name);
+    fprintf(stderr, "Usage: %s <inputfile | -> [-o <outputfile>]\n", prog_name);
 }
 
 int main(int argc, char **argv)
@@ -46,37 +67,35 @@ int main(int argc, char **argv)
         output_file = argv[3];
     }
 
-    size_t file_size;
-    uint8_t *source = read_source_file(input_file, &file_size);
-    if (!source)
+    source_buffer_t source;
+    if (!read_source_file(input_file, &source))
     {
         fprintf(stderr, "Error: Failed to read input file '%s'.\n", input_file);
         return EXIT_FAILURE;
     }
 
-    token_list_t token_list;
-    token_t *tokens = (token_t *)allocate(sizeof(token_t) * MAX_TOKEN_NUMBER);
-    if (!tokens)
-    {
-        perror("malloc");
-        return EXIT_FAILURE;
-    }
+    // every phase allocates its nodes from its own arena, which is dropped once the next phase has consumed them
+    arena_t ast_arena, ir_arena, asm_arena;
+    arena_init(&ast_arena);
+    arena_init(&ir_arena);
+    arena_init(&asm_arena);
+
+    enter_phase(&ast_arena);
+
+    lexer_t lexer;
+    init_lexer(&lexer, source.data, source.size);
+
+    parser_t *parser = init_streaming_parser(&lexer);
+    program_t *ast = parse_program(parser);
 
-    token_list.tokens = tokens;
+    release_source_file(&source);
 
-    token_list.count = 0;
-    if (!lex_source(source, &token_list))
+    if (lexer.failed)
     {
         fprintf(stderr, "Error: Lexing failed for file '%s'.\n", input_file);
-        free(source);
         return EXIT_FAILURE;
     }
 
-    free(source);
-
-    parser_t *parser = init_parser(token_list.tokens, token_list.count);
-    program_t *ast = parse_program(parser);
-
     if (!ast)
     {
         fprintf(stderr, "Error: Parsing failed for file '%s'.\n", input_file);
@@ -89,14 +108,34 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    enter_phase(&ir_arena);
     ir_program_t *ir_program = conv_ast_to_ir(ast);
+    arena_release(&ast_arena);
     if (!ir_program)
     {
         fprintf(stderr, "Error: IR generation failed\n");
         return EXIT_FAILURE;
     }
 
+    if (!optimize_ir_program(ir_program))
+    {
+        fprintf(stderr, "Error: IR optimization failed\n");
+        return EXIT_FAILURE;
+    }
+
+#ifdef DUMP_IR
+    ir_cfg_t ir_cfg;
+    if (ir_cfg_build(ir_program->function, &ir_cfg))
+    {
+        ir_cfg_print(&ir_cfg, stderr);
+    }
+    ir_cfg_linearize(&ir_cfg);
+    ir_cfg_free(&ir_cfg);
+#endif
+
+    enter_phase(&asm_arena);
     asm_program_t *asm_program = asm_first_pass(ir_program);
+    arena_release(&ir_arena);
     if (!asm_program)
     {
         fprintf(stderr, "Error: First Assembly Generation pass failed\n");
@@ -117,12 +156,27 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    if (!emit_asm_program(asm_program, output_file))
+    if (!asm_peephole_pass(asm_program))
+    {
+        fprintf(stderr, "Error: Peephole pass failed\n");
+        return EXIT_FAILURE;
+    }
+
+    bool emitted = emit_asm_program(asm_program, output_file);
+    arena_release(&asm_arena);
+    if (!emitted)
     {
         fprintf(stderr, "Error: Failed to write output to '%s'.\n", output_file);
         return EXIT_FAILURE;
     }
 
+#if defined(DEBUG) && defined(CUSTOM_ALLOCATOR)
+    pool_print_stats(stderr);
+#endif
+#ifdef PEEPHOLE_STATS
+    asm_peephole_print_stats(stderr);
+#endif
+
     printf("Assembly successfully written to '%s'.\n", output_file);
     return EXIT_SUCCESS;
 }
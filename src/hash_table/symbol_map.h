@@ -0,0 +1,225 @@
+#ifndef C8E2A4D1_6B37_4F95_9A0C_E3715D8B2F46
+#define C8E2A4D1_6B37_4F95_9A0C_E3715D8B2F46
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../allocator/allocator.h"
+#include "../string_container/string_interner.h"
+
+/*
+Open addressing map keyed on interned symbols, using Robin Hood probing: an entry that is
+further from its home slot takes the place of one that is closer, which keeps probe
+sequences short even at high load. Entries are stored inline with their hash and the
+table doubles once it is 7/8 full. Removal shifts the following entries back instead
+of leaving tombstones.
+*/
+
+#define SYMBOL_MAP_MIN_CAPACITY 16 // should always be a power of two
+
+typedef struct
+{
+    symbol_t key; // SYMBOL_NONE marks an empty slot
+    uint32_t hash;
+    union
+    {
+        symbol_t symbol;
+        int integer;
+    } value;
+} symbol_map_entry_t;
+
+typedef struct
+{
+    symbol_map_entry_t *entries;
+    size_t capacity;
+    size_t count;
+} symbol_map_t;
+
+bool symbol_map_init(symbol_map_t *map, size_t capacity_hint);
+void symbol_map_destroy(symbol_map_t *map);
+symbol_map_entry_t *symbol_map_find(const symbol_map_t *map, symbol_t key);
+symbol_map_entry_t *symbol_map_insert(symbol_map_t *map, symbol_t key);
+bool symbol_map_remove(symbol_map_t *map, symbol_t key);
+void symbol_map_clear(symbol_map_t *map);
+
+static inline uint32_t symbol_map_hash(symbol_t key)
+{
+    // symbols are dense small integers, a multiplicative hash spreads them over the table
+    return key * 2654435761u;
+}
+
+static inline size_t symbol_map_distance(const symbol_map_t *map, size_t slot, uint32_t hash)
+{
+    return (slot - (hash & (map->capacity - 1))) & (map->capacity - 1);
+}
+
+bool symbol_map_init(symbol_map_t *map, size_t capacity_hint)
+{
+    size_t capacity = SYMBOL_MAP_MIN_CAPACITY;
+    while (capacity - capacity / 8 < capacity_hint)
+    {
+        capacity <<= 1;
+    }
+
+    map->entries = (symbol_map_entry_t *)allocate(capacity * sizeof(symbol_map_entry_t));
+    if (!map->entries)
+    {
+        return false;
+    }
+
+    memset(map->entries, 0, capacity * sizeof(symbol_map_entry_t));
+    map->capacity = capacity;
+    map->count = 0;
+    return true;
+}
+
+void symbol_map_destroy(symbol_map_t *map)
+{
+    if (!map)
+    {
+        return;
+    }
+
+    deallocate(map->entries);
+    map->entries = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+
+symbol_map_entry_t *symbol_map_find(const symbol_map_t *map, symbol_t key)
+{
+    if (!map || !map->entries || key == SYMBOL_NONE)
+    {
+        return NULL;
+    }
+
+    uint32_t hash = symbol_map_hash(key);
+    size_t mask = map->capacity - 1;
+
+    for (size_t slot = hash & mask, distance = 0;; slot = (slot + 1) & mask, distance++)
+    {
+        symbol_map_entry_t *entry = &map->entries[slot];
+        if (entry->key == SYMBOL_NONE || symbol_map_distance(map, slot, entry->hash) < distance)
+        {
+            return NULL;
+        }
+
+        if (entry->key == key)
+        {
+            return entry;
+        }
+    }
+}
+
+// Places an entry without checking for an existing key, returns its final slot
+static symbol_map_entry_t *symbol_map_place(symbol_map_t *map, symbol_map_entry_t entry)
+{
+    size_t mask = map->capacity - 1;
+    symbol_map_entry_t *placed = NULL;
+
+    for (size_t slot = entry.hash & mask, distance = 0;; slot = (slot + 1) & mask, distance++)
+    {
+        symbol_map_entry_t *current = &map->entries[slot];
+        if (current->key == SYMBOL_NONE)
+        {
+            *current = entry;
+            map->count++;
+            return placed ? placed : current;
+        }
+
+        size_t current_distance = symbol_map_distance(map, slot, current->hash);
+        if (current_distance < distance)
+        {
+            symbol_map_entry_t displaced = *current;
+            *current = entry;
+            if (!placed)
+            {
+                placed = current;
+            }
+
+            entry = displaced;
+            distance = current_distance;
+        }
+    }
+}
+
+static bool symbol_map_grow(symbol_map_t *map)
+{
+    symbol_map_t grown;
+    if (!symbol_map_init(&grown, map->capacity))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        if (map->entries[i].key != SYMBOL_NONE)
+        {
+            symbol_map_place(&grown, map->entries[i]);
+        }
+    }
+
+    deallocate(map->entries);
+    *map = grown;
+    return true;
+}
+
+// Adds key with a zeroed value, NULL if the key is already present or memory ran out
+symbol_map_entry_t *symbol_map_insert(symbol_map_t *map, symbol_t key)
+{
+    if (!map || !map->entries || key == SYMBOL_NONE || symbol_map_find(map, key))
+    {
+        return NULL;
+    }
+
+    if (map->count + 1 > map->capacity - map->capacity / 8 && !symbol_map_grow(map))
+    {
+        return NULL;
+    }
+
+    return symbol_map_place(map, (symbol_map_entry_t){.key = key, .hash = symbol_map_hash(key)});
+}
+
+bool symbol_map_remove(symbol_map_t *map, symbol_t key)
+{
+    symbol_map_entry_t *entry = symbol_map_find(map, key);
+    if (!entry)
+    {
+        return false;
+    }
+
+    size_t mask = map->capacity - 1;
+    size_t slot = (size_t)(entry - map->entries);
+
+    while (true)
+    {
+        size_t next = (slot + 1) & mask;
+        symbol_map_entry_t *following = &map->entries[next];
+        if (following->key == SYMBOL_NONE || symbol_map_distance(map, next, following->hash) == 0)
+        {
+            break;
+        }
+
+        map->entries[slot] = *following;
+        slot = next;
+    }
+
+    memset(&map->entries[slot], 0, sizeof(symbol_map_entry_t));
+    map->count--;
+    return true;
+}
+
+void symbol_map_clear(symbol_map_t *map)
+{
+    if (!map || !map->entries)
+    {
+        return;
+    }
+
+    memset(map->entries, 0, map->capacity * sizeof(symbol_map_entry_t));
+    map->count = 0;
+}
+
+#undef SYMBOL_MAP_MIN_CAPACITY
+
+#endif /* C8E2A4D1_6B37_4F95_9A0C_E3715D8B2F46 */
@@ -0,0 +1,126 @@
+#ifndef E62D0B95_48A1_4C7E_9F36_B1A8D52C07E4
+#define E62D0B95_48A1_4C7E_9F36_B1A8D52C07E4
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+Intrusive doubly linked list shared by IR and assembly functions. Every instruction embeds an
+instr_link_t, and the list owns a sentinel link, so inserting or removing next to any instruction
+is O(1) and never touches the rest of the function. INSTR_LIST_ENTRY turns a link back into the
+instruction that contains it.
+*/
+
+typedef struct instr_link_
+{
+    struct instr_link_ *prev;
+    struct instr_link_ *next;
+} instr_link_t;
+
+typedef struct
+{
+    instr_link_t head; // sentinel, head.next is the first instruction and head.prev the last
+    size_t count;
+} instr_list_t;
+
+#define INSTR_LIST_ENTRY(link_ptr, type, member) \
+    ((type *)((char *)(link_ptr) - offsetof(type, member)))
+
+// Visits every link of the list, the current link may be removed or have links inserted around it
+#define INSTR_LIST_FOR_EACH(link_var, list)                                                    \
+    for (instr_link_t *link_var = (list)->head.next, *link_var##_next = link_var->next;         \
+         link_var != &(list)->head;                                                              \
+         link_var = link_var##_next, link_var##_next = link_var->next)
+
+static inline void instr_list_init(instr_list_t *list)
+{
+    list->head.prev = &list->head;
+    list->head.next = &list->head;
+    list->count = 0;
+}
+
+static inline bool instr_list_empty(const instr_list_t *list)
+{
+    return list->head.next == &list->head;
+}
+
+static inline instr_link_t *instr_list_first(instr_list_t *list)
+{
+    return instr_list_empty(list) ? NULL : list->head.next;
+}
+
+static inline instr_link_t *instr_list_last(instr_list_t *list)
+{
+    return instr_list_empty(list) ? NULL : list->head.prev;
+}
+
+// Neighbours of link, NULL at either end of the list
+static inline instr_link_t *instr_list_next(instr_list_t *list, instr_link_t *link)
+{
+    return link->next == &list->head ? NULL : link->next;
+}
+
+static inline instr_link_t *instr_list_prev(instr_list_t *list, instr_link_t *link)
+{
+    return link->prev == &list->head ? NULL : link->prev;
+}
+
+static inline void instr_list_link_between(instr_list_t *list, instr_link_t *link, instr_link_t *prev, instr_link_t *next)
+{
+    link->prev = prev;
+    link->next = next;
+    prev->next = link;
+    next->prev = link;
+    list->count++;
+}
+
+static inline void instr_list_insert_before(instr_list_t *list, instr_link_t *position, instr_link_t *link)
+{
+    instr_list_link_between(list, link, position->prev, position);
+}
+
+static inline void instr_list_insert_after(instr_list_t *list, instr_link_t *position, instr_link_t *link)
+{
+    instr_list_link_between(list, link, position, position->next);
+}
+
+static inline void instr_list_push_back(instr_list_t *list, instr_link_t *link)
+{
+    instr_list_link_between(list, link, list->head.prev, &list->head);
+}
+
+static inline void instr_list_push_front(instr_list_t *list, instr_link_t *link)
+{
+    instr_list_link_between(list, link, &list->head, list->head.next);
+}
+
+static inline void instr_list_remove(instr_list_t *list, instr_link_t *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = NULL;
+    link->next = NULL;
+    list->count--;
+}
+
+// Moves every link of source to the end of destination, leaving source empty
+static inline void instr_list_splice_back(instr_list_t *destination, instr_list_t *source)
+{
+    if (instr_list_empty(source))
+    {
+        return;
+    }
+
+    instr_link_t *first = source->head.next;
+    instr_link_t *last = source->head.prev;
+
+    first->prev = destination->head.prev;
+    last->next = &destination->head;
+    destination->head.prev->next = first;
+    destination->head.prev = last;
+    destination->count += source->count;
+
+    instr_list_init(source);
+}
+
+#endif /* E62D0B95_48A1_4C7E_9F36_B1A8D52C07E4 */
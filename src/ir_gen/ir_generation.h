@@ -5,28 +5,26 @@
 #include "../ast/IR/ir_ast.h"
 #include "../ast/source/ast.h"
 #include "../allocator/allocator.h"
+#include "../hash_table/symbol_map.h"
 
-#define NULL_INSTRUCTION_STRUCT ((ir_instruction_struct_t){0})
-#define MAX_TEMP_VAR_LENGTH 16
-#define MAX_LABEL_LENGTH 16
+#define MAX_TEMP_VAR_LENGTH 32
 
 #define DEBUG_NULL_RETURN(func_name) \
     fprintf(stderr, "NULL return in %s at line %d\n", func_name, __LINE__)
 
-size_t temp_var_count = 0;
 size_t false_label_count = 0;
 size_t end_label_count = 0;
 
+symbol_map_t local_vregs; // resolved local name -> virtual register of the function being lowered
+
 ir_program_t *conv_ast_to_ir(program_t *source_program);
 ir_function_t *ir_handle_function(function_def_t *source_function);
-ir_instruction_struct_t ir_handle_statement(statement_t *source_statement);
-ir_instruction_struct_t ir_handle_expression(expression_t *source_expression);
+bool ir_handle_statement(statement_t *source_statement, ir_function_t *ir_function);
+ir_value_t *ir_handle_expression(expression_t *source_expression, ir_function_t *ir_function);
 ir_program_t *ir_handle_program(program_t *source_program);
 ir_identifier_t *ir_handle_identifier(identifier_t *source_identifier);
 ir_unary_operator_t *ir_handle_unary_operator(unary_operator_t *source_unary_operator);
-ir_instruction_struct_t ir_handle_declaration(declaration_t *source_declaration);
-
-char *new_temp_var_name();
+bool ir_handle_declaration(declaration_t *source_declaration, ir_function_t *ir_function);
 
 ir_binary_operator_t *ir_handle_binary_operator(binary_operator_t *source_binary_operator)
 {
@@ -122,59 +120,26 @@ ir_program_t *conv_ast_to_ir(program_t *source_program)
     return ir_handle_program(source_program);
 }
 
-char *new_temp_var_name()
+static symbol_t intern_generated_name(const char *prefix, size_t *counter)
 {
-    char *temp_var_name = (char *)allocate(sizeof(char) * MAX_TEMP_VAR_LENGTH);
-    if (!temp_var_name)
-    {
-        DEBUG_NULL_RETURN("new_temp_var_name");
-        return NULL;
-    }
-
-    int r = snprintf(temp_var_name, MAX_TEMP_VAR_LENGTH, ".tmp%zu", temp_var_count++);
-    if (r > MAX_TEMP_VAR_LENGTH || r < 4)
+    char name[MAX_TEMP_VAR_LENGTH];
+    int r = snprintf(name, sizeof(name), "%s%zu", prefix, (*counter)++);
+    if (r < 0 || (size_t)r >= sizeof(name))
     {
-        deallocate(temp_var_name);
-        return NULL;
+        return SYMBOL_NONE;
     }
 
-    return temp_var_name;
+    return intern_string(name, (size_t)r);
 }
 
-char *new_false_label_name()
+symbol_t new_false_label_name()
 {
-    char *temp_label_name = (char *)allocate(sizeof(char) * MAX_LABEL_LENGTH);
-    if (!temp_label_name)
-    {
-        return NULL;
-    }
-
-    int r = snprintf(temp_label_name, MAX_LABEL_LENGTH, ".L_false%zu", false_label_count++);
-    if (r > MAX_TEMP_VAR_LENGTH || r < 8)
-    {
-        deallocate(temp_label_name);
-        return NULL;
-    }
-
-    return temp_label_name;
+    return intern_generated_name(".L_false", &false_label_count);
 }
 
-char *new_end_label_name()
+symbol_t new_end_label_name()
 {
-    char *temp_label_name = (char *)allocate(sizeof(char) * MAX_LABEL_LENGTH);
-    if (!temp_label_name)
-    {
-        return NULL;
-    }
-
-    int r = snprintf(temp_label_name, MAX_LABEL_LENGTH, ".L_end%zu", end_label_count++);
-    if (r > MAX_TEMP_VAR_LENGTH || r < 6)
-    {
-        deallocate(temp_label_name);
-        return NULL;
-    }
-
-    return temp_label_name;
+    return intern_generated_name(".L_end", &end_label_count);
 }
 
 ir_unary_operator_t *ir_handle_unary_operator(unary_operator_t *source_unary_operator)
@@ -213,1096 +178,433 @@ ir_unary_operator_t *ir_handle_unary_operator(unary_operator_t *source_unary_ope
     return ir_unary_operator;
 }
 
-ir_instruction_struct_t ir_handle_expression(expression_t *source_expression)
+/*
+Lowering appends straight to the body of the function being generated and every expression
+hands back the operand holding its result: a constant, a variable or the temporary it wrote.
+The returned operand is a fresh node owned by whichever instruction consumes it, so no two
+instructions ever share an ir_value_t and a pass can rewrite one use without touching the def.
+*/
+
+static ir_identifier_t *ir_new_identifier(symbol_t name, ir_ast_node_t *parent)
 {
-    if (!source_expression)
+    ir_identifier_t *ir_identifier = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
+    if (!ir_identifier)
     {
-        DEBUG_NULL_RETURN("ir_handle_expression");
-        return NULL_INSTRUCTION_STRUCT;
+        return NULL;
+    }
+
+    ir_identifier->base.type = IR_NODE_IDENTIFIER;
+    ir_identifier->base.parent = parent;
+    ir_identifier->name = name;
+    return ir_identifier;
+}
+
+static ir_value_t *ir_new_constant(int constant_int)
+{
+    ir_value_t *ir_value = (ir_value_t *)allocate(sizeof(ir_value_t));
+    if (!ir_value)
+    {
+        return NULL;
     }
 
-    expression_type_t source_expression_type = source_expression->expr_type;
+    ir_value->base.type = IR_NODE_VALUE;
+    ir_value->base.parent = NULL;
+    ir_value->type = IR_VAL_CONSTANT_INT;
+    ir_value->value.constant_int = constant_int;
+    return ir_value;
+}
 
-    switch (source_expression_type)
+static ir_value_t *ir_new_variable(uint32_t vreg, symbol_t name)
+{
+    ir_value_t *ir_value = (ir_value_t *)allocate(sizeof(ir_value_t));
+    if (!ir_value)
     {
-    case EXPR_ASSIGN:
+        return NULL;
+    }
+
+    ir_value->base.type = IR_NODE_VALUE;
+    ir_value->base.parent = NULL;
+    ir_value->type = IR_VAL_VARIABLE;
+    ir_value->value.variable.vreg = vreg;
+    ir_value->value.variable.name = name;
+    return ir_value;
+}
+
+static ir_value_t *ir_new_temp(ir_function_t *ir_function)
+{
+    return ir_new_variable(ir_function->vreg_count++, SYMBOL_NONE);
+}
+
+// Locals are already unique after variable resolution, each one gets its register on first use
+static ir_value_t *ir_new_local(ir_function_t *ir_function, symbol_t name)
+{
+    symbol_map_entry_t *entry = symbol_map_find(&local_vregs, name);
+    if (!entry)
     {
-        assignment_t assign = source_expression->value.assign;
-        expression_t *init_expr = assign.rvalue;
-        if (!init_expr)
+        entry = symbol_map_insert(&local_vregs, name);
+        if (!entry)
         {
-            return NULL_INSTRUCTION_STRUCT;
+            return NULL;
         }
+        entry->value.integer = (int)ir_function->vreg_count++;
+    }
 
-        ir_instruction_struct_t init_expr_ins = ir_handle_expression(init_expr);
-        ir_value_t *init_expr_val = NULL;
+    return ir_new_variable((uint32_t)entry->value.integer, name);
+}
 
-        if (init_expr_ins.instruction_count > 0)
-        {
-            init_expr_val = allocate(sizeof(ir_value_t));
-            init_expr_val->base.type = IR_NODE_VALUE;
-            init_expr_val->base.parent = NULL;
-            init_expr_val->type = IR_VAL_VARIABLE;
+// Fresh operand naming the same constant or variable as value
+static ir_value_t *ir_new_use(const ir_value_t *value)
+{
+    if (value->type == IR_VAL_CONSTANT_INT)
+    {
+        return ir_new_constant(value->value.constant_int);
+    }
 
-            ir_instruction_t *last_instruction = init_expr_ins.instructions[init_expr_ins.instruction_count - 1];
-            switch (last_instruction->type)
-            {
-            case IR_INSTR_LABEL:
-            {
-                ir_instruction_t *copy_result = init_expr_ins.instructions[init_expr_ins.instruction_count - 2];
-                init_expr_val->value.variable.identifier = copy_result->instruction.copy_instr.destination->value.variable.identifier;
-                break;
-            }
-            case IR_INSTR_BINARY:
-                init_expr_val->value.variable.identifier =
-                    last_instruction->instruction.binary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_UNARY:
-                init_expr_val->value.variable.identifier =
-                    last_instruction->instruction.unary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_RETURN:
-                init_expr_val->value.variable.identifier =
-                    last_instruction->instruction.return_instr.value->value.variable.identifier;
-                break;
-            default:
-                init_expr_val = NULL;
-                break;
-            }
-        }
+    return ir_new_variable(value->value.variable.vreg, value->value.variable.name);
+}
 
-        if (!init_expr_val)
-        {
-            if (init_expr_ins.instructions == (void *)0)
-            {
-                init_expr_val = allocate(sizeof(ir_value_t));
-                init_expr_val->base.type = IR_NODE_VALUE;
-                init_expr_val->base.parent = NULL;
-                init_expr_val->type = IR_VAL_CONSTANT_INT;
-                init_expr_val->value.constant_int = init_expr->value.constant_int;
-            }
-            else if (init_expr_ins.instructions == (void *)1)
-            {
-                init_expr_val = allocate(sizeof(ir_value_t));
-                init_expr_val->base.type = IR_NODE_VALUE;
-                init_expr_val->base.parent = NULL;
-                init_expr_val->type = IR_VAL_VARIABLE;
-                ir_identifier_t *iden = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-                if (!iden)
-                {
-                    return NULL_INSTRUCTION_STRUCT;
-                }
-
-                iden->base.parent = &(init_expr_val->base);
-                iden->base.type = IR_NODE_IDENTIFIER;
-                iden->name = strdup(init_expr->value.var.name->name);
-
-                init_expr_val->value.variable.identifier = iden;
-            }
-        }
+static ir_instruction_t *ir_new_instruction(ir_function_t *ir_function, ir_instruction_type_t type)
+{
+    ir_instruction_t *ir_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
+    if (!ir_instruction)
+    {
+        return NULL;
+    }
 
-        ir_instruction_t *copy_zero = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-        if (!copy_zero)
-        {
-            return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-        }
-        copy_zero->base.type = IR_NODE_INSTRUCTION;
-        copy_zero->type = IR_INSTR_COPY;
+    ir_instruction->base.type = IR_NODE_INSTRUCTION;
+    ir_instruction->base.parent = &(ir_function->base);
+    ir_instruction->type = type;
+    ir_instruction->link.prev = NULL;
+    ir_instruction->link.next = NULL;
+    return ir_instruction;
+}
+
+// Creates the instruction and links it at the end of the function body
+static ir_instruction_t *ir_emit_instruction(ir_function_t *ir_function, ir_instruction_type_t type)
+{
+    ir_instruction_t *ir_instruction = ir_new_instruction(ir_function, type);
+    if (!ir_instruction)
+    {
+        return NULL;
+    }
 
-        init_expr_val->base.parent = &(copy_zero->base);
+    instr_list_push_back(&ir_function->body, &ir_instruction->link);
+    return ir_instruction;
+}
 
-        copy_zero->instruction.copy_instr.source = init_expr_val;
+static bool ir_emit_copy(ir_function_t *ir_function, ir_value_t *source, ir_value_t *destination)
+{
+    ir_instruction_t *copy = ir_emit_instruction(ir_function, IR_INSTR_COPY);
+    if (!copy)
+    {
+        return false;
+    }
 
-        ir_value_t *dest = (ir_value_t *)allocate(sizeof(ir_value_t));
-        if (!dest)
-        {
-            return NULL_INSTRUCTION_STRUCT;
-        }
+    source->base.parent = &copy->base;
+    destination->base.parent = &copy->base;
+    copy->instruction.copy_instr.source = source;
+    copy->instruction.copy_instr.destination = destination;
+    return true;
+}
 
-        dest->base.parent = &(copy_zero->base);
-        dest->base.type = IR_NODE_VALUE;
+static bool ir_emit_label(ir_function_t *ir_function, symbol_t label)
+{
+    ir_instruction_t *label_instr = ir_emit_instruction(ir_function, IR_INSTR_LABEL);
+    if (!label_instr)
+    {
+        return false;
+    }
 
-        ir_identifier_t *iden_var = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-        if (!iden_var)
-        {
-            return NULL_INSTRUCTION_STRUCT;
-        }
+    label_instr->instruction.label_instr.identifier = ir_new_identifier(label, &label_instr->base);
+    return label_instr->instruction.label_instr.identifier != NULL;
+}
 
-        iden_var->base.parent = &(dest->base);
-        iden_var->base.type = IR_NODE_IDENTIFIER;
-        iden_var->name = assign.lvalue->value.var.name->name;
-        if (!iden_var->name)
-        {
-            return NULL_INSTRUCTION_STRUCT;
-        }
+static bool ir_emit_jump(ir_function_t *ir_function, symbol_t target)
+{
+    ir_instruction_t *jmp = ir_emit_instruction(ir_function, IR_INSTR_JUMP);
+    if (!jmp)
+    {
+        return false;
+    }
 
-        dest->value.variable.identifier = iden_var;
-        dest->type = IR_VAL_VARIABLE;
+    jmp->instruction.jmp_instr.target = ir_new_identifier(target, &jmp->base);
+    return jmp->instruction.jmp_instr.target != NULL;
+}
 
-        copy_zero->instruction.copy_instr.destination = dest;
+// Emits jz (type IR_INSTR_JUMP_IF_ZERO) or jnz on condition
+static bool ir_emit_conditional_jump(ir_function_t *ir_function, ir_instruction_type_t type,
+                                     ir_value_t *condition, symbol_t target)
+{
+    ir_instruction_t *jump = ir_emit_instruction(ir_function, type);
+    if (!jump)
+    {
+        return false;
+    }
 
-        ir_instruction_t **total_inst = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * (init_expr_ins.instruction_count + 1));
-        if (!total_inst)
-        {
-            return NULL_INSTRUCTION_STRUCT;
-        }
+    ir_identifier_t *ir_target = ir_new_identifier(target, &jump->base);
+    if (!ir_target)
+    {
+        return false;
+    }
 
-        for (size_t counter = 0; counter < init_expr_ins.instruction_count; counter++)
-        {
-            total_inst[counter] = init_expr_ins.instructions[counter];
-        }
+    condition->base.parent = &jump->base;
+    if (type == IR_INSTR_JUMP_IF_ZERO)
+    {
+        jump->instruction.jz_instr = (ir_instruction_jz_t){.condition = condition, .target = ir_target};
+    }
+    else
+    {
+        jump->instruction.jnz_instr = (ir_instruction_jnz_t){.condition = condition, .target = ir_target};
+    }
+    return true;
+}
 
-        total_inst[init_expr_ins.instruction_count] = copy_zero;
-        deallocate(init_expr_ins.instructions);
+/*
+&& and || short circuit:
+    left; jz/jnz left, short; right; jz/jnz right, short;
+    result = !short_value; jmp end; short: result = short_value; end:
+*/
+static ir_value_t *ir_handle_logical_expression(expression_t *source_left_expr, expression_t *source_right_expr,
+                                                bool is_and, ir_function_t *ir_function)
+{
+    ir_instruction_type_t jump_type = is_and ? IR_INSTR_JUMP_IF_ZERO : IR_INSTR_JUMP_IF_NOT_ZERO;
+    int short_value = is_and ? 0 : 1;
 
-        return (ir_instruction_struct_t){.instructions = total_inst, .instruction_count = (init_expr_ins.instruction_count + 1)};
+    symbol_t short_label = new_false_label_name();
+    symbol_t end_label = new_end_label_name();
+    if (short_label == SYMBOL_NONE || end_label == SYMBOL_NONE)
+    {
+        return NULL;
     }
-    case EXPR_VAR:
+
+    ir_value_t *ir_left_value = ir_handle_expression(source_left_expr, ir_function);
+    if (!ir_left_value || !ir_emit_conditional_jump(ir_function, jump_type, ir_left_value, short_label))
     {
-        return (ir_instruction_struct_t){.instructions = (void *)1, .instruction_count = 0};
+        return NULL;
     }
-    case EXPR_CONSTANT_INT:
+
+    ir_value_t *ir_right_value = ir_handle_expression(source_right_expr, ir_function);
+    if (!ir_right_value || !ir_emit_conditional_jump(ir_function, jump_type, ir_right_value, short_label))
     {
-        return (ir_instruction_struct_t){.instructions = (void *)0, .instruction_count = 0};
+        return NULL;
     }
-    case EXPR_BINARY:
+
+    ir_value_t *result = ir_new_temp(ir_function);
+    if (!result)
     {
-        expression_t *source_left_expr = source_expression->value.binary.left_expr;
-        expression_t *source_right_expr = source_expression->value.binary.right_expr;
-        binary_operator_t *source_binary_operator = source_expression->value.binary.op;
+        return NULL;
+    }
 
-        if (!source_left_expr || !source_right_expr || !source_binary_operator)
+    ir_value_t *fallthrough_result = ir_new_use(result);
+    ir_value_t *fallthrough_value = ir_new_constant(!short_value);
+    if (!fallthrough_result || !fallthrough_value ||
+        !ir_emit_copy(ir_function, fallthrough_value, fallthrough_result) ||
+        !ir_emit_jump(ir_function, end_label) ||
+        !ir_emit_label(ir_function, short_label))
+    {
+        return NULL;
+    }
+
+    ir_value_t *short_result = ir_new_use(result);
+    ir_value_t *short_circuit_value = ir_new_constant(short_value);
+    if (!short_result || !short_circuit_value ||
+        !ir_emit_copy(ir_function, short_circuit_value, short_result) ||
+        !ir_emit_label(ir_function, end_label))
+    {
+        return NULL;
+    }
+
+    return result;
+}
+
+ir_value_t *ir_handle_expression(expression_t *source_expression, ir_function_t *ir_function)
+{
+    if (!source_expression)
+    {
+        DEBUG_NULL_RETURN("ir_handle_expression");
+        return NULL;
+    }
+
+    switch (source_expression->expr_type)
+    {
+    case EXPR_CONSTANT_INT:
+    {
+        return ir_new_constant(source_expression->value.constant_int);
+    }
+    case EXPR_VAR:
+    {
+        return ir_new_local(ir_function, source_expression->value.var.name->name);
+    }
+    case EXPR_NESTED:
+    {
+        return ir_handle_expression(source_expression->value.nested_expr, ir_function);
+    }
+    case EXPR_ASSIGN:
+    {
+        assignment_t assign = source_expression->value.assign;
+        if (!assign.rvalue || !assign.lvalue)
         {
-            fprintf(stderr, "Invalid binary expression components\n");
-            return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
         }
 
-        ir_instruction_struct_t ir_left_instruction_struct = ir_handle_expression(source_left_expr);
-        ir_instruction_struct_t ir_right_instruction_struct = ir_handle_expression(source_right_expr);
-        ir_value_t *ir_left_value = NULL;
-        ir_value_t *ir_right_value = NULL;
+        ir_value_t *ir_rvalue = ir_handle_expression(assign.rvalue, ir_function);
+        ir_value_t *ir_lvalue = ir_new_local(ir_function, assign.lvalue->value.var.name->name);
+        if (!ir_rvalue || !ir_lvalue || !ir_emit_copy(ir_function, ir_rvalue, ir_lvalue))
+        {
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
+        }
 
-        if (ir_left_instruction_struct.instruction_count > 0)
+        // the value of an assignment is the variable after the store
+        return ir_new_local(ir_function, assign.lvalue->value.var.name->name);
+    }
+    case EXPR_UNARY:
+    {
+        unary_t source_unary = source_expression->value.unary;
+        if (!source_unary.unary_operator || !source_unary.expression)
         {
-            ir_left_value = allocate(sizeof(ir_value_t));
-            ir_left_value->base.type = IR_NODE_VALUE;
-            ir_left_value->base.parent = NULL;
-            ir_left_value->type = IR_VAL_VARIABLE;
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
+        }
 
-            ir_instruction_t *last_instruction = ir_left_instruction_struct.instructions[ir_left_instruction_struct.instruction_count - 1];
-            switch (last_instruction->type)
-            {
-            case IR_INSTR_LABEL:
-            {
-                ir_instruction_t *copy_result = ir_left_instruction_struct.instructions[ir_left_instruction_struct.instruction_count - 2];
-                ir_left_value->value.variable.identifier = copy_result->instruction.copy_instr.destination->value.variable.identifier;
-                break;
-            }
-            case IR_INSTR_BINARY:
-                ir_left_value->value.variable.identifier =
-                    last_instruction->instruction.binary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_UNARY:
-                ir_left_value->value.variable.identifier =
-                    last_instruction->instruction.unary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_RETURN:
-                ir_left_value->value.variable.identifier =
-                    last_instruction->instruction.return_instr.value->value.variable.identifier;
-                break;
-            default:
-                ir_left_value = NULL;
-                break;
-            }
+        ir_value_t *ir_source_value = ir_handle_expression(source_unary.expression, ir_function);
+        ir_unary_operator_t *ir_unary_operator = ir_handle_unary_operator(source_unary.unary_operator);
+        ir_value_t *ir_destination_value = ir_new_temp(ir_function);
+        if (!ir_source_value || !ir_unary_operator || !ir_destination_value)
+        {
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
         }
 
-        if (ir_right_instruction_struct.instruction_count > 0)
+        ir_instruction_t *ir_unary_instruction = ir_emit_instruction(ir_function, IR_INSTR_UNARY);
+        if (!ir_unary_instruction)
         {
-            ir_right_value = allocate(sizeof(ir_value_t));
-            ir_right_value->base.type = IR_NODE_VALUE;
-            ir_right_value->base.parent = NULL;
-            ir_right_value->type = IR_VAL_VARIABLE;
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
+        }
 
-            ir_instruction_t *last_instruction = ir_right_instruction_struct.instructions[ir_right_instruction_struct.instruction_count - 1];
-            switch (last_instruction->type)
-            {
-            case IR_INSTR_LABEL:
-            {
-                ir_instruction_t *copy_result = ir_right_instruction_struct.instructions[ir_right_instruction_struct.instruction_count - 2];
-                ir_right_value->value.variable.identifier = copy_result->instruction.copy_instr.destination->value.variable.identifier;
-                break;
-            }
-            case IR_INSTR_BINARY:
-                ir_right_value->value.variable.identifier =
-                    last_instruction->instruction.binary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_UNARY:
-                ir_right_value->value.variable.identifier =
-                    last_instruction->instruction.unary_instr.destination->value.variable.identifier;
-                break;
-            case IR_INSTR_RETURN:
-                ir_right_value->value.variable.identifier =
-                    last_instruction->instruction.return_instr.value->value.variable.identifier;
-                break;
-            default:
-                ir_right_value = NULL;
-                break;
-            }
+        ir_unary_operator->base.parent = &ir_unary_instruction->base;
+        ir_source_value->base.parent = &ir_unary_instruction->base;
+        ir_destination_value->base.parent = &ir_unary_instruction->base;
+        ir_unary_instruction->instruction.unary_instr.unary_operator = ir_unary_operator;
+        ir_unary_instruction->instruction.unary_instr.source = ir_source_value;
+        ir_unary_instruction->instruction.unary_instr.destination = ir_destination_value;
+
+        return ir_new_use(ir_destination_value);
+    }
+    case EXPR_BINARY:
+    {
+        expression_t *source_left_expr = source_expression->value.binary.left_expr;
+        expression_t *source_right_expr = source_expression->value.binary.right_expr;
+        binary_operator_t *source_binary_operator = source_expression->value.binary.op;
+
+        if (!source_left_expr || !source_right_expr || !source_binary_operator)
+        {
+            fprintf(stderr, "Invalid binary expression components\n");
+            return NULL;
         }
 
-        if (!ir_left_value)
+        switch (source_binary_operator->binary_operator)
         {
-            if (ir_left_instruction_struct.instructions == (void *)0)
-            {
-                ir_left_value = allocate(sizeof(ir_value_t));
-                ir_left_value->base.type = IR_NODE_VALUE;
-                ir_left_value->base.parent = NULL;
-                ir_left_value->type = IR_VAL_CONSTANT_INT;
-                ir_left_value->value.constant_int = source_left_expr->value.constant_int;
-            }
-            else if (ir_left_instruction_struct.instructions == (void *)1)
-            {
-                ir_left_value = allocate(sizeof(ir_value_t));
-                ir_left_value->base.type = IR_NODE_VALUE;
-                ir_left_value->base.parent = NULL;
-                ir_left_value->type = IR_VAL_VARIABLE;
-                ir_identifier_t *iden = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-                if (!iden)
-                {
-                    return NULL_INSTRUCTION_STRUCT;
-                }
-
-                iden->base.parent = &(ir_left_value->base);
-                iden->base.type = IR_NODE_IDENTIFIER;
-                iden->name = strdup(source_left_expr->value.var.name->name);
-
-                ir_left_value->value.variable.identifier = iden;
-            }
+        case BINARY_LOGICAL_AND:
+            return ir_handle_logical_expression(source_left_expr, source_right_expr, true, ir_function);
+        case BINARY_LOGICAL_OR:
+            return ir_handle_logical_expression(source_left_expr, source_right_expr, false, ir_function);
+        default:
+            break;
         }
 
-        if (!ir_right_value)
+        ir_value_t *ir_left_value = ir_handle_expression(source_left_expr, ir_function);
+        ir_value_t *ir_right_value = ir_handle_expression(source_right_expr, ir_function);
+        if (!ir_left_value || !ir_right_value)
         {
-            if (ir_right_instruction_struct.instructions == (void *)0)
-            {
-                ir_right_value = allocate(sizeof(ir_value_t));
-                ir_right_value->base.type = IR_NODE_VALUE;
-                ir_right_value->base.parent = NULL;
-                ir_right_value->type = IR_VAL_CONSTANT_INT;
-                ir_right_value->value.constant_int = source_right_expr->value.constant_int;
-            }
-            else if (ir_right_instruction_struct.instructions == (void *)1)
-            {
-                ir_right_value = allocate(sizeof(ir_value_t));
-                ir_right_value->base.type = IR_NODE_VALUE;
-                ir_right_value->base.parent = NULL;
-                ir_right_value->type = IR_VAL_VARIABLE;
-                ir_identifier_t *iden = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-                if (!iden)
-                {
-                    return NULL_INSTRUCTION_STRUCT;
-                }
-
-                iden->base.parent = &(ir_right_value->base);
-                iden->base.type = IR_NODE_IDENTIFIER;
-                iden->name = strdup(source_right_expr->value.var.name->name);
-
-                ir_right_value->value.variable.identifier = iden;
-            }
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
         }
 
         ir_binary_operator_t *ir_binary_operator = ir_handle_binary_operator(source_binary_operator);
         if (!ir_binary_operator)
         {
             fprintf(stderr, "Failed to create binary operator\n");
-            if (ir_left_instruction_struct.instructions)
-                deallocate(ir_left_instruction_struct.instructions);
-            if (ir_right_instruction_struct.instructions)
-                deallocate(ir_right_instruction_struct.instructions);
-            return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
+            return NULL;
         }
 
-        ir_value_t *ir_destination_value = allocate(sizeof(ir_value_t));
-        ir_destination_value->base.type = IR_NODE_VALUE;
-        ir_destination_value->type = IR_VAL_VARIABLE;
+        ir_value_t *ir_destination_value = ir_new_temp(ir_function);
+        if (!ir_destination_value)
+        {
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
+        }
 
-        char *temp_var_name = new_temp_var_name();
-        if (!temp_var_name)
+        ir_instruction_t *ir_binary_instruction = ir_emit_instruction(ir_function, IR_INSTR_BINARY);
+        if (!ir_binary_instruction)
         {
-            return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
+            DEBUG_NULL_RETURN("ir_handle_expression");
+            return NULL;
         }
-        ir_destination_value->value.variable.identifier = allocate(sizeof(ir_identifier_t));
-        ir_destination_value->value.variable.identifier->base.type = IR_NODE_IDENTIFIER;
-        ir_destination_value->value.variable.identifier->name = temp_var_name;
 
-        ir_instruction_t *ir_binary_instruction = allocate(sizeof(ir_instruction_t));
-        ir_binary_instruction->base.type = IR_NODE_INSTRUCTION;
-        ir_binary_instruction->type = IR_INSTR_BINARY;
+        ir_binary_operator->base.parent = &ir_binary_instruction->base;
+        ir_left_value->base.parent = &ir_binary_instruction->base;
+        ir_right_value->base.parent = &ir_binary_instruction->base;
+        ir_destination_value->base.parent = &ir_binary_instruction->base;
         ir_binary_instruction->instruction.binary_instr.binary_operator = ir_binary_operator;
         ir_binary_instruction->instruction.binary_instr.left = ir_left_value;
         ir_binary_instruction->instruction.binary_instr.right = ir_right_value;
         ir_binary_instruction->instruction.binary_instr.destination = ir_destination_value;
 
-        size_t total_instruction_count = 0;
-        if (ir_binary_operator->operator== IR_BINARY_LOGICAL_AND)
-        {
-            total_instruction_count = ir_left_instruction_struct.instruction_count +
-                                      ir_right_instruction_struct.instruction_count + 7;
-        }
-        else if (ir_binary_operator->operator== IR_BINARY_LOGICAL_OR)
-        {
-            total_instruction_count =
-                ir_left_instruction_struct.instruction_count +
-                ir_right_instruction_struct.instruction_count + 7;
-        }
-        else
-        {
-            total_instruction_count =
-                ir_left_instruction_struct.instruction_count +
-                ir_right_instruction_struct.instruction_count + 1;
-        }
+        return ir_new_use(ir_destination_value);
+    }
+    default:
+    {
+        DEBUG_NULL_RETURN("ir_handle_expression");
+        return NULL;
+    }
+    }
+}
 
-        ir_instruction_t **combined_instructions = allocate(
-            sizeof(ir_instruction_t *) * total_instruction_count);
+bool ir_handle_statement(statement_t *source_statement, ir_function_t *ir_function)
+{
+    if (!source_statement)
+    {
+        DEBUG_NULL_RETURN("ir_handle_statement");
+        return false;
+    }
 
-        size_t current_index = 0;
-        for (size_t i = 0; i < ir_left_instruction_struct.instruction_count; i++)
+    switch (source_statement->stmt_type)
+    {
+    case STMT_NULL:
+    {
+        return true;
+    }
+    case STMT_EXPR:
+    {
+        return ir_handle_expression(source_statement->value.expr, ir_function) != NULL;
+    }
+    case STMT_RETURN:
+    {
+        ir_value_t *ir_return_value = ir_handle_expression(source_statement->value.return_expr, ir_function);
+        if (!ir_return_value)
         {
-            combined_instructions[current_index++] =
-                ir_left_instruction_struct.instructions[i];
+            DEBUG_NULL_RETURN("ir_handle_statement");
+            return false;
         }
 
-        if (ir_binary_operator->operator== IR_BINARY_LOGICAL_AND)
+        ir_instruction_t *ir_return_instruction = ir_emit_instruction(ir_function, IR_INSTR_RETURN);
+        if (!ir_return_instruction)
         {
-            ir_value_t *result_var = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!result_var)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            result_var->base.type = IR_NODE_VALUE;
-            result_var->type = IR_VAL_VARIABLE;
-
-            ir_identifier_t *result_identifier = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!result_identifier)
-            {
-                deallocate(result_var);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            result_identifier->base.type = IR_NODE_IDENTIFIER;
-            result_identifier->base.parent = &result_var->base;
-            result_identifier->name = new_temp_var_name();
-            if (!result_identifier->name)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            result_var->value.variable.identifier = result_identifier;
+            DEBUG_NULL_RETURN("ir_handle_statement");
+            return false;
+        }
 
-            ir_identifier_t *false_label = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!false_label)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            false_label->base.type = IR_NODE_IDENTIFIER;
-            false_label->name = new_false_label_name();
-            if (!false_label->name)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                deallocate(false_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            ir_instruction_t *first_jz_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!first_jz_instruction)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                deallocate(false_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            first_jz_instruction->base.type = IR_NODE_INSTRUCTION;
-            first_jz_instruction->type = IR_INSTR_JUMP_IF_ZERO;
-            false_label->base.parent = &first_jz_instruction->base;
-
-            ir_identifier_t *first_jz_target = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!first_jz_target)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                deallocate(false_label);
-                deallocate(first_jz_instruction);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            first_jz_target->base.type = IR_NODE_IDENTIFIER;
-            first_jz_target->base.parent = &first_jz_instruction->base;
-            first_jz_target->name = strdup(false_label->name);
-            if (!first_jz_target->name)
-            {
-                deallocate(result_var);
-                deallocate(result_identifier);
-                deallocate(false_label);
-                deallocate(first_jz_instruction);
-                deallocate(first_jz_target);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            first_jz_instruction->instruction.jz_instr.condition = ir_left_value;
-            first_jz_instruction->instruction.jz_instr.target = first_jz_target;
-            ir_left_value->base.parent = &first_jz_instruction->base;
-
-            combined_instructions[current_index++] = first_jz_instruction;
-
-            for (size_t i = 0; i < ir_right_instruction_struct.instruction_count; i++)
-            {
-                combined_instructions[current_index++] = ir_right_instruction_struct.instructions[i];
-                ir_right_instruction_struct.instructions[i]->base.parent = &result_var->base;
-            }
-
-            ir_instruction_t *second_jz_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!second_jz_instruction)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            second_jz_instruction->base.type = IR_NODE_INSTRUCTION;
-            second_jz_instruction->type = IR_INSTR_JUMP_IF_ZERO;
-
-            ir_identifier_t *second_jz_target = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!second_jz_target)
-            {
-                deallocate(second_jz_instruction);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            second_jz_target->base.type = IR_NODE_IDENTIFIER;
-            second_jz_target->base.parent = &second_jz_instruction->base;
-            second_jz_target->name = strdup(false_label->name);
-            if (!second_jz_target->name)
-            {
-                deallocate(second_jz_instruction);
-                deallocate(second_jz_target);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            second_jz_instruction->instruction.jz_instr.condition = ir_right_value;
-            second_jz_instruction->instruction.jz_instr.target = second_jz_target;
-            ir_right_value->base.parent = &second_jz_instruction->base;
-
-            combined_instructions[current_index++] = second_jz_instruction;
-
-            ir_instruction_t *copy_true = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!copy_true)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            copy_true->base.type = IR_NODE_INSTRUCTION;
-            copy_true->type = IR_INSTR_COPY;
-
-            ir_value_t *true_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!true_value)
-            {
-                deallocate(copy_true);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            true_value->base.type = IR_NODE_VALUE;
-            true_value->base.parent = &copy_true->base;
-            true_value->type = IR_VAL_CONSTANT_INT;
-            true_value->value.constant_int = 1;
-
-            copy_true->instruction.copy_instr.destination = result_var;
-            copy_true->instruction.copy_instr.source = true_value;
-            result_var->base.parent = &copy_true->base;
-
-            combined_instructions[current_index++] = copy_true;
-
-            ir_identifier_t *end_label = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!end_label)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            end_label->base.type = IR_NODE_IDENTIFIER;
-            end_label->name = new_end_label_name();
-            if (!end_label->name)
-            {
-                deallocate(end_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            ir_instruction_t *unconditional_jmp = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!unconditional_jmp)
-            {
-                deallocate(end_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            unconditional_jmp->base.type = IR_NODE_INSTRUCTION;
-            unconditional_jmp->type = IR_INSTR_JUMP;
-            end_label->base.parent = &unconditional_jmp->base;
-
-            ir_identifier_t *jmp_target = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!jmp_target)
-            {
-                deallocate(unconditional_jmp);
-                deallocate(end_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            jmp_target->base.type = IR_NODE_IDENTIFIER;
-            jmp_target->base.parent = &unconditional_jmp->base;
-            jmp_target->name = strdup(end_label->name);
-            if (!jmp_target->name)
-            {
-                deallocate(unconditional_jmp);
-                deallocate(end_label);
-                deallocate(jmp_target);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            unconditional_jmp->instruction.jmp_instr.target = jmp_target;
-            combined_instructions[current_index++] = unconditional_jmp;
-
-            ir_instruction_t *false_label_instr = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!false_label_instr)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            false_label_instr->base.type = IR_NODE_INSTRUCTION;
-            false_label_instr->type = IR_INSTR_LABEL;
-            false_label_instr->instruction.label_instr.identifier = false_label;
-            false_label->base.parent = &false_label_instr->base;
-
-            combined_instructions[current_index++] = false_label_instr;
-
-            ir_instruction_t *copy_false = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!copy_false)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            copy_false->base.type = IR_NODE_INSTRUCTION;
-            copy_false->type = IR_INSTR_COPY;
-
-            ir_value_t *false_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!false_value)
-            {
-                deallocate(copy_false);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            false_value->base.type = IR_NODE_VALUE;
-            false_value->base.parent = &copy_false->base;
-            false_value->type = IR_VAL_CONSTANT_INT;
-            false_value->value.constant_int = 0;
-
-            copy_false->instruction.copy_instr.destination = result_var;
-            copy_false->instruction.copy_instr.source = false_value;
-            result_var->base.parent = &copy_false->base;
-
-            combined_instructions[current_index++] = copy_false;
-
-            ir_instruction_t *end_label_instr = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!end_label_instr)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            end_label_instr->base.type = IR_NODE_INSTRUCTION;
-            end_label_instr->type = IR_INSTR_LABEL;
-            end_label_instr->instruction.label_instr.identifier = end_label;
-            end_label->base.parent = &end_label_instr->base;
-
-            combined_instructions[current_index++] = end_label_instr;
-        }
-        else if (ir_binary_operator->operator== IR_BINARY_LOGICAL_OR)
-        {
-            ir_instruction_t *jnz_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!jnz_instruction)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            jnz_instruction->base.type = IR_NODE_INSTRUCTION;
-            jnz_instruction->type = IR_INSTR_JUMP_IF_NOT_ZERO;
-
-            ir_identifier_t *true_label = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!true_label)
-            {
-                deallocate(jnz_instruction);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            true_label->base.type = IR_NODE_IDENTIFIER;
-            true_label->base.parent = &jnz_instruction->base;
-            true_label->name = new_false_label_name();
-            if (!true_label->name)
-            {
-                deallocate(jnz_instruction);
-                deallocate(true_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            jnz_instruction->instruction.jnz_instr.condition = ir_left_value;
-            jnz_instruction->instruction.jnz_instr.target = true_label;
-            ir_left_value->base.parent = &jnz_instruction->base;
-
-            combined_instructions[current_index++] = jnz_instruction;
-
-            for (size_t i = 0; i < ir_right_instruction_struct.instruction_count; i++)
-            {
-                combined_instructions[current_index++] = ir_right_instruction_struct.instructions[i];
-                ir_right_instruction_struct.instructions[i]->base.parent = &jnz_instruction->base;
-            }
-
-            ir_instruction_t *jnz_instruction2 = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!jnz_instruction2)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            jnz_instruction2->base.type = IR_NODE_INSTRUCTION;
-            jnz_instruction2->type = IR_INSTR_JUMP_IF_NOT_ZERO;
-            jnz_instruction2->instruction.jnz_instr.condition = ir_right_value;
-            jnz_instruction2->instruction.jnz_instr.target = true_label;
-            ir_right_value->base.parent = &jnz_instruction2->base;
-
-            combined_instructions[current_index++] = jnz_instruction2;
-
-            ir_instruction_t *copy_zero = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!copy_zero)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            copy_zero->base.type = IR_NODE_INSTRUCTION;
-            copy_zero->type = IR_INSTR_COPY;
-
-            ir_value_t *zero_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!zero_value)
-            {
-                deallocate(copy_zero);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            zero_value->base.type = IR_NODE_VALUE;
-            zero_value->base.parent = &copy_zero->base;
-            zero_value->type = IR_VAL_CONSTANT_INT;
-            zero_value->value.constant_int = 0;
-
-            copy_zero->instruction.copy_instr.source = zero_value;
-            copy_zero->instruction.copy_instr.destination = ir_destination_value;
-            ir_destination_value->base.parent = &copy_zero->base;
-
-            combined_instructions[current_index++] = copy_zero;
-
-            ir_instruction_t *jmp_end = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!jmp_end)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            jmp_end->base.type = IR_NODE_INSTRUCTION;
-            jmp_end->type = IR_INSTR_JUMP;
-
-            ir_identifier_t *end_label = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!end_label)
-            {
-                deallocate(jmp_end);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            end_label->base.type = IR_NODE_IDENTIFIER;
-            end_label->base.parent = &jmp_end->base;
-            end_label->name = new_end_label_name();
-            if (!end_label->name)
-            {
-                deallocate(jmp_end);
-                deallocate(end_label);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-
-            jmp_end->instruction.jmp_instr.target = end_label;
-            combined_instructions[current_index++] = jmp_end;
-
-            ir_instruction_t *true_label_instr = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!true_label_instr)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            true_label_instr->base.type = IR_NODE_INSTRUCTION;
-            true_label_instr->type = IR_INSTR_LABEL;
-            true_label_instr->instruction.label_instr.identifier = true_label;
-            true_label->base.parent = &true_label_instr->base;
-
-            combined_instructions[current_index++] = true_label_instr;
-
-            ir_instruction_t *copy_one = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!copy_one)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            copy_one->base.type = IR_NODE_INSTRUCTION;
-            copy_one->type = IR_INSTR_COPY;
-
-            ir_value_t *one_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!one_value)
-            {
-                deallocate(copy_one);
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            one_value->base.type = IR_NODE_VALUE;
-            one_value->base.parent = &copy_one->base;
-            one_value->type = IR_VAL_CONSTANT_INT;
-            one_value->value.constant_int = 1;
-
-            copy_one->instruction.copy_instr.source = one_value;
-            copy_one->instruction.copy_instr.destination = ir_destination_value;
-            ir_destination_value->base.parent = &copy_one->base;
-
-            combined_instructions[current_index++] = copy_one;
-
-            ir_instruction_t *end_label_instr = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-            if (!end_label_instr)
-            {
-                return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-            }
-            end_label_instr->base.type = IR_NODE_INSTRUCTION;
-            end_label_instr->type = IR_INSTR_LABEL;
-            end_label_instr->instruction.label_instr.identifier = end_label;
-            end_label->base.parent = &end_label_instr->base;
-
-            combined_instructions[current_index++] = end_label_instr;
-        }
-        else
-        {
-            for (size_t i = 0; i < ir_right_instruction_struct.instruction_count; i++)
-            {
-                combined_instructions[current_index++] = ir_right_instruction_struct.instructions[i];
-            }
-
-            combined_instructions[current_index++] = ir_binary_instruction;
-        }
-
-        if (ir_left_instruction_struct.instructions != NULL && ir_left_instruction_struct.instructions != (void *)1 && ir_left_instruction_struct.instructions != (void *)2)
-            deallocate(ir_left_instruction_struct.instructions);
-        if (ir_right_instruction_struct.instructions != NULL && ir_right_instruction_struct.instructions != (void *)1 && ir_right_instruction_struct.instructions != (void *)2)
-            deallocate(ir_right_instruction_struct.instructions);
-
-        return (ir_instruction_struct_t){
-            .instructions = combined_instructions,
-            .instruction_count = total_instruction_count};
-    }
-    case EXPR_UNARY:
-    {
-        unary_t source_unary = source_expression->value.unary;
-        unary_operator_t *source_unary_operator = source_unary.unary_operator;
-        expression_t *source_unary_expression = source_unary.expression;
-
-        if (!source_unary_operator || !source_unary_expression)
-        {
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        ir_instruction_struct_t ir_source_instruction_struct = ir_handle_expression(source_unary_expression);
-
-        ir_unary_operator_t *ir_unary_operator = ir_handle_unary_operator(source_unary_operator);
-        if (!ir_unary_operator)
-        {
-            if (ir_source_instruction_struct.instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-            }
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        ir_value_t *ir_source_value = ir_source_instruction_struct.instruction_count > 0
-                                          ? ir_source_instruction_struct.instructions[ir_source_instruction_struct.instruction_count - 1]->instruction.unary_instr.destination
-                                          : NULL;
-
-        if (!ir_source_value)
-        {
-            ir_source_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!ir_source_value)
-            {
-                if (ir_source_instruction_struct.instructions)
-                {
-                    deallocate(ir_source_instruction_struct.instructions);
-                }
-                DEBUG_NULL_RETURN("ir_handle_expression");
-                return NULL_INSTRUCTION_STRUCT;
-            }
-            ir_source_value->base.type = IR_NODE_VALUE;
-            ir_source_value->type = IR_VAL_CONSTANT_INT;
-            ir_source_value->value.constant_int = source_unary_expression->value.constant_int;
-        }
-
-        ir_value_t *ir_destination_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-        if (!ir_destination_value)
-        {
-            if (ir_source_instruction_struct.instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-            }
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-        ir_destination_value->base.type = IR_NODE_VALUE;
-        ir_destination_value->type = IR_VAL_VARIABLE;
-
-        char *temp_var_name = new_temp_var_name();
-        if (!temp_var_name)
-        {
-            if (ir_source_instruction_struct.instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-            }
-            deallocate(ir_destination_value);
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-        ir_destination_value->value.variable.identifier = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-        if (!ir_destination_value->value.variable.identifier)
-        {
-            if (ir_source_instruction_struct.instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-            }
-            deallocate(ir_destination_value);
-            deallocate(temp_var_name);
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-        ir_destination_value->value.variable.identifier->base.type = IR_NODE_IDENTIFIER;
-        ir_destination_value->value.variable.identifier->name = temp_var_name;
-
-        ir_instruction_t *ir_unary_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-        if (!ir_unary_instruction)
-        {
-            if (ir_source_instruction_struct.instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-            }
-            deallocate(ir_destination_value);
-            DEBUG_NULL_RETURN("ir_handle_expression");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        ir_unary_instruction->base.type = IR_NODE_INSTRUCTION;
-        ir_unary_instruction->type = IR_INSTR_UNARY;
-        ir_unary_instruction->instruction.unary_instr.unary_operator = ir_unary_operator;
-        ir_unary_instruction->instruction.unary_instr.source = ir_source_value;
-        ir_unary_instruction->instruction.unary_instr.destination = ir_destination_value;
-
-        if (ir_source_instruction_struct.instruction_count > 0)
-        {
-            ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(
-                sizeof(ir_instruction_t *) * (ir_source_instruction_struct.instruction_count + 1));
-
-            if (!new_instructions)
-            {
-                deallocate(ir_source_instruction_struct.instructions);
-                deallocate(ir_unary_instruction);
-                DEBUG_NULL_RETURN("ir_handle_expression");
-                return NULL_INSTRUCTION_STRUCT;
-            }
-
-            for (size_t counter = 0; counter < ir_source_instruction_struct.instruction_count; counter++)
-            {
-                new_instructions[counter] = ir_source_instruction_struct.instructions[counter];
-            }
-
-            new_instructions[ir_source_instruction_struct.instruction_count] = ir_unary_instruction;
-
-            deallocate(ir_source_instruction_struct.instructions);
-
-            return (ir_instruction_struct_t){
-                .instructions = new_instructions,
-                .instruction_count = ir_source_instruction_struct.instruction_count + 1};
-        }
-        else
-        {
-            ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *));
-            if (!new_instructions)
-            {
-                deallocate(ir_unary_instruction);
-                DEBUG_NULL_RETURN("ir_handle_expression");
-                return NULL_INSTRUCTION_STRUCT;
-            }
-            new_instructions[0] = ir_unary_instruction;
-
-            return (ir_instruction_struct_t){
-                .instructions = new_instructions,
-                .instruction_count = 1};
-        }
-    }
-    case EXPR_NESTED:
-    {
-        return ir_handle_expression(source_expression->value.nested_expr);
+        ir_return_value->base.parent = &ir_return_instruction->base;
+        ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){.value = ir_return_value};
+        return true;
     }
     default:
-    {
-        DEBUG_NULL_RETURN("ir_handle_expression");
-        return NULL_INSTRUCTION_STRUCT;
-    }
-    }
-}
-
-ir_instruction_struct_t ir_handle_statement(statement_t *source_statement)
-{
-    if (!source_statement)
     {
         DEBUG_NULL_RETURN("ir_handle_statement");
-        return NULL_INSTRUCTION_STRUCT;
-    }
-
-    statement_type_t source_statement_type = source_statement->stmt_type;
-    switch (source_statement_type)
-    {
-    case STMT_NULL:
-    {
-        return (ir_instruction_struct_t){
-            .instruction_count = 0,
-            .instructions = (void *)2,
-        };
-        break;
-    }
-    case STMT_EXPR:
-    {
-        return ir_handle_expression(source_statement->value.expr);
-        break;
-    }
-    case STMT_RETURN:
-    {
-        // return(val)
-        expression_t *source_return_expression = source_statement->value.return_expr;
-        if (!source_return_expression)
-        {
-            DEBUG_NULL_RETURN("ir_handle_statement");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        ir_instruction_struct_t ir_return_val_instruction_struct = ir_handle_expression(source_return_expression);
-
-        ir_instruction_t **ir_return_val_instructions = ir_return_val_instruction_struct.instructions;
-        size_t ir_return_val_instruction_count = ir_return_val_instruction_struct.instruction_count;
-
-        ir_instruction_t *ir_return_instruction = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-        if (!ir_return_instruction && !ir_return_val_instructions)
-        {
-            // deallocate previously allocated memory
-            for (size_t i = 0; i < ir_return_val_instruction_count; i++)
-            {
-                deallocate(ir_return_val_instructions[i]);
-            }
-            deallocate(ir_return_val_instructions);
-            DEBUG_NULL_RETURN("ir_handle_statement");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        ir_return_instruction->base.type = IR_NODE_INSTRUCTION;
-        ir_return_instruction->type = IR_INSTR_RETURN;
-
-        if (ir_return_val_instruction_struct.instructions == (void *)0)
-        {
-            ir_value_t *ir_instruction_return_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!ir_instruction_return_value)
-            {
-                deallocate(ir_return_instruction);
-                DEBUG_NULL_RETURN("ir_handle_statement");
-                return NULL_INSTRUCTION_STRUCT;
-            }
-
-            ir_instruction_return_value->base.type = IR_NODE_VALUE;
-            ir_instruction_return_value->base.parent = &(ir_return_instruction->base);
-            ir_instruction_return_value->type = IR_VAL_CONSTANT_INT;
-            ir_instruction_return_value->value.constant_int = source_return_expression->value.constant_int;
-
-            ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){.value = ir_instruction_return_value};
-
-            return (ir_instruction_struct_t){
-                .instructions = &ir_return_instruction,
-                .instruction_count = 1};
-        }
-        else if (ir_return_val_instruction_struct.instructions == (void *)1)
-        {
-            ir_value_t *ir_instruction_return_value = (ir_value_t *)allocate(sizeof(ir_value_t));
-            if (!ir_instruction_return_value)
-            {
-                deallocate(ir_return_instruction);
-                DEBUG_NULL_RETURN("ir_handle_statement");
-                return NULL_INSTRUCTION_STRUCT;
-            }
-
-            ir_instruction_return_value->base.type = IR_NODE_VALUE;
-            ir_instruction_return_value->base.parent = &(ir_return_instruction->base);
-            ir_instruction_return_value->type = IR_VAL_VARIABLE;
-
-            ir_identifier_t *iden = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!iden)
-            {
-                return NULL_INSTRUCTION_STRUCT;
-            }
-
-            iden->base.parent = &(ir_return_instruction->base);
-            iden->base.type = IR_NODE_IDENTIFIER;
-            iden->name = source_return_expression->value.var.name->name;
-            ir_instruction_return_value->value.variable.identifier = iden;
-
-            ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){.value = ir_instruction_return_value};
-
-            return (ir_instruction_struct_t){
-                .instructions = &ir_return_instruction,
-                .instruction_count = 1};
-        }
-
-        ir_instruction_t *last_instruction = ir_return_val_instructions[ir_return_val_instruction_count - 1];
-        switch (last_instruction->type)
-        {
-        case IR_INSTR_LABEL:
-        {
-            ir_instruction_t *copy_result = ir_return_val_instructions[ir_return_val_instruction_count - 2];
-            ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){
-                .value = copy_result->instruction.copy_instr.destination,
-            };
-            break;
-        }
-        case IR_INSTR_BINARY:
-        {
-            ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){
-                .value = last_instruction->instruction.binary_instr.destination,
-            };
-            break;
-        }
-        case IR_INSTR_UNARY:
-        {
-            ir_return_instruction->instruction.return_instr = (ir_instruction_return_t){
-                .value = last_instruction->instruction.unary_instr.destination};
-            break;
-        }
-        default:
-            break;
-        }
-
-        ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(
-            sizeof(ir_instruction_t *) * (ir_return_val_instruction_count + 1));
-
-        if (!new_instructions)
-        {
-            deallocate(ir_return_instruction);
-            for (size_t i = 0; i < ir_return_val_instruction_count; i++)
-            {
-                deallocate(ir_return_val_instructions[i]);
-            }
-            deallocate(ir_return_val_instructions);
-            DEBUG_NULL_RETURN("ir_handle_statement");
-            return NULL_INSTRUCTION_STRUCT;
-        }
-
-        memcpy(new_instructions, ir_return_val_instructions,
-               sizeof(ir_instruction_t *) * ir_return_val_instruction_count);
-
-        new_instructions[ir_return_val_instruction_count] = ir_return_instruction;
-
-        deallocate(ir_return_val_instructions);
-
-        return (ir_instruction_struct_t){
-            .instructions = new_instructions,
-            .instruction_count = ir_return_val_instruction_count + 1};
-    }
-    default:
-    {
-        DEBUG_NULL_RETURN("ir_handle_statement");
-        return NULL_INSTRUCTION_STRUCT;
+        return false;
     }
     }
 }
@@ -1323,8 +625,8 @@ ir_identifier_t *ir_handle_identifier(identifier_t *source_identifier)
     }
     ir_identifier->base.type = IR_NODE_IDENTIFIER;
 
-    char *name = source_identifier->name;
-    if (!name)
+    symbol_t name = source_identifier->name;
+    if (name == SYMBOL_NONE)
     {
         deallocate(ir_identifier);
         DEBUG_NULL_RETURN("ir_handle_identifier");
@@ -1367,141 +669,21 @@ ir_program_t *ir_handle_program(program_t *source_program)
     return ir_program;
 }
 
-ir_instruction_struct_t ir_handle_declaration(declaration_t *source_declaration)
+bool ir_handle_declaration(declaration_t *source_declaration, ir_function_t *ir_function)
 {
-    if (!source_declaration)
+    if (!source_declaration || !source_declaration->init_expr)
     {
-        return NULL_INSTRUCTION_STRUCT;
+        return false;
     }
 
-    expression_t *init_expr = source_declaration->init_expr;
-    if (!init_expr)
+    ir_value_t *init_expr_val = ir_handle_expression(source_declaration->init_expr, ir_function);
+    ir_value_t *dest = ir_new_local(ir_function, source_declaration->name->name);
+    if (!init_expr_val || !dest)
     {
-        return NULL_INSTRUCTION_STRUCT;
+        return false;
     }
 
-    ir_instruction_struct_t init_expr_ins = ir_handle_expression(init_expr);
-    ir_value_t *init_expr_val = NULL;
-
-    if (init_expr_ins.instruction_count > 0)
-    {
-        init_expr_val = allocate(sizeof(ir_value_t));
-        init_expr_val->base.type = IR_NODE_VALUE;
-        init_expr_val->base.parent = NULL;
-        init_expr_val->type = IR_VAL_VARIABLE;
-
-        ir_instruction_t *last_instruction = init_expr_ins.instructions[init_expr_ins.instruction_count - 1];
-        switch (last_instruction->type)
-        {
-        case IR_INSTR_LABEL:
-        {
-            ir_instruction_t *copy_result = init_expr_ins.instructions[init_expr_ins.instruction_count - 2];
-            init_expr_val->value.variable.identifier = copy_result->instruction.copy_instr.destination->value.variable.identifier;
-            break;
-        }
-        case IR_INSTR_BINARY:
-            init_expr_val->value.variable.identifier =
-                last_instruction->instruction.binary_instr.destination->value.variable.identifier;
-            break;
-        case IR_INSTR_UNARY:
-            init_expr_val->value.variable.identifier =
-                last_instruction->instruction.unary_instr.destination->value.variable.identifier;
-            break;
-        case IR_INSTR_RETURN:
-            init_expr_val->value.variable.identifier =
-                last_instruction->instruction.return_instr.value->value.variable.identifier;
-            break;
-        default:
-            init_expr_val = NULL;
-            break;
-        }
-    }
-
-    if (!init_expr_val)
-    {
-        if (init_expr_ins.instructions == (void *)0)
-        {
-            init_expr_val = allocate(sizeof(ir_value_t));
-            init_expr_val->base.type = IR_NODE_VALUE;
-            init_expr_val->base.parent = NULL;
-            init_expr_val->type = IR_VAL_CONSTANT_INT;
-            init_expr_val->value.constant_int = init_expr->value.constant_int;
-        }
-        else
-        {
-            init_expr_val = allocate(sizeof(ir_value_t));
-            init_expr_val->base.type = IR_NODE_VALUE;
-            init_expr_val->base.parent = NULL;
-            init_expr_val->type = IR_VAL_VARIABLE;
-            ir_identifier_t *iden = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-            if (!iden)
-            {
-                return NULL_INSTRUCTION_STRUCT;
-            }
-
-            iden->base.parent = &(init_expr_val->base);
-            iden->base.type = IR_NODE_IDENTIFIER;
-            iden->name = strdup(init_expr->value.var.name->name);
-
-            init_expr_val->value.variable.identifier = iden;
-        }
-    }
-
-    ir_instruction_t *copy_zero = (ir_instruction_t *)allocate(sizeof(ir_instruction_t));
-    if (!copy_zero)
-    {
-        return (ir_instruction_struct_t){.instructions = NULL, .instruction_count = 0};
-    }
-    copy_zero->base.type = IR_NODE_INSTRUCTION;
-    copy_zero->type = IR_INSTR_COPY;
-
-    init_expr_val->base.parent = &(copy_zero->base);
-
-    copy_zero->instruction.copy_instr.source = init_expr_val;
-
-    ir_value_t *dest = (ir_value_t *)allocate(sizeof(ir_value_t));
-    if (!dest)
-    {
-        return NULL_INSTRUCTION_STRUCT;
-    }
-
-    dest->base.parent = &(copy_zero->base);
-    dest->base.type = IR_NODE_VALUE;
-
-    ir_identifier_t *iden_var = (ir_identifier_t *)allocate(sizeof(ir_identifier_t));
-    if (!iden_var)
-    {
-        return NULL_INSTRUCTION_STRUCT;
-    }
-
-    iden_var->base.parent = &(dest->base);
-    iden_var->base.type = IR_NODE_IDENTIFIER;
-    iden_var->name = source_declaration->name->name;
-    if (!iden_var->name)
-    {
-        return NULL_INSTRUCTION_STRUCT;
-    }
-
-    dest->type = IR_VAL_VARIABLE;
-    dest->value.variable.identifier = iden_var;
-
-    copy_zero->instruction.copy_instr.destination = dest;
-
-    ir_instruction_t **total_inst = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * (init_expr_ins.instruction_count + 1));
-    if (!total_inst)
-    {
-        return NULL_INSTRUCTION_STRUCT;
-    }
-
-    for (size_t counter = 0; counter < init_expr_ins.instruction_count; counter++)
-    {
-        total_inst[counter] = init_expr_ins.instructions[counter];
-    }
-
-    total_inst[init_expr_ins.instruction_count] = copy_zero;
-    deallocate(init_expr_ins.instructions);
-
-    return (ir_instruction_struct_t){.instructions = total_inst, .instruction_count = (init_expr_ins.instruction_count + 1)};
+    return ir_emit_copy(ir_function, init_expr_val, dest);
 }
 
 ir_function_t *ir_handle_function(function_def_t *source_function)
@@ -1532,21 +714,15 @@ ir_function_t *ir_handle_function(function_def_t *source_function)
     ir_identifier->base.parent = &(ir_function->base);
     ir_function->name = ir_identifier;
 
-#define MAX_TOTAL_INSTRUCTIONS 1024
-
-    size_t current_max_instructions = MAX_TOTAL_INSTRUCTIONS;
-    ir_instruction_t **ir_instructions = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * current_max_instructions);
-    if (!ir_instructions)
+    instr_list_init(&ir_function->body);
+    ir_function->vreg_count = 0;
+    if (!symbol_map_init(&local_vregs, 64))
     {
-        deallocate(ir_identifier);
-        deallocate(ir_function);
-        DEBUG_NULL_RETURN("ir_handle_function");
-        return NULL;
+        goto cleanup_and_return;
     }
 
     block_item_t **source_body = source_function->body;
     size_t source_body_count = source_function->block_count;
-    size_t curr_index = 0;
 
     for (size_t counter = 0; counter < source_body_count; counter++)
     {
@@ -1556,129 +732,28 @@ ir_function_t *ir_handle_function(function_def_t *source_function)
             goto cleanup_and_return;
         }
 
-        if (curr_index >= current_max_instructions)
-        {
-            size_t new_size = current_max_instructions * 2;
-            ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * new_size);
-            if (!new_instructions)
-            {
-                goto cleanup_and_return;
-            }
-
-            for (size_t i = 0; i < curr_index; i++)
-            {
-                new_instructions[i] = ir_instructions[i];
-            }
-
-            deallocate(ir_instructions);
-            ir_instructions = new_instructions;
-            current_max_instructions = new_size;
-        }
-
         switch (block->type)
         {
         case BLOCK_STATEMENT:
         {
-            ir_instruction_struct_t stmt_inst = ir_handle_statement(block->value.statement);
-            if (!stmt_inst.instructions)
+            if (!ir_handle_statement(block->value.statement, ir_function))
             {
                 goto cleanup_and_return;
             }
-
-            if (stmt_inst.instructions == (void *)2)
-            {
-                continue;
-            }
-
-            if (curr_index + stmt_inst.instruction_count > current_max_instructions)
-            {
-                size_t new_size = current_max_instructions * 2;
-                while (curr_index + stmt_inst.instruction_count > new_size)
-                {
-                    new_size *= 2;
-                }
-
-                ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * new_size);
-                if (!new_instructions)
-                {
-                    for (size_t i = 0; i < stmt_inst.instruction_count; i++)
-                    {
-                        deallocate(stmt_inst.instructions[i]);
-                    }
-                    goto cleanup_and_return;
-                }
-
-                for (size_t i = 0; i < curr_index; i++)
-                {
-                    new_instructions[i] = ir_instructions[i];
-                }
-
-                deallocate(ir_instructions);
-                ir_instructions = new_instructions;
-                current_max_instructions = new_size;
-            }
-            for (size_t i = 0; i < stmt_inst.instruction_count; i++)
-            {
-                ir_instructions[curr_index++] = stmt_inst.instructions[i];
-                stmt_inst.instructions[i]->base.parent = &(ir_function->base);
-            }
-
             break;
         }
         case BLOCK_DECLARATION:
         {
             declaration_t *source_decl = block->value.declaration;
             if (!source_decl)
-            {
-                return NULL;
-            }
-
-            if (!source_decl->has_init_expr)
-            {
-                continue;
-            }
-
-            ir_instruction_struct_t decl_inst = ir_handle_declaration(block->value.declaration);
-            if (!decl_inst.instructions)
             {
                 goto cleanup_and_return;
             }
 
-            if (curr_index + decl_inst.instruction_count > current_max_instructions)
+            if (source_decl->has_init_expr && !ir_handle_declaration(source_decl, ir_function))
             {
-                size_t new_size = current_max_instructions * 2;
-                while (curr_index + decl_inst.instruction_count > new_size)
-                {
-                    new_size *= 2;
-                }
-
-                ir_instruction_t **new_instructions = (ir_instruction_t **)allocate(sizeof(ir_instruction_t *) * new_size);
-                if (!new_instructions)
-                {
-                    for (size_t i = 0; i < decl_inst.instruction_count; i++)
-                    {
-                        deallocate(decl_inst.instructions[i]);
-                    }
-                    goto cleanup_and_return;
-                }
-
-                for (size_t i = 0; i < curr_index; i++)
-                {
-                    new_instructions[i] = ir_instructions[i];
-                }
-
-                deallocate(ir_instructions);
-                ir_instructions = new_instructions;
-                current_max_instructions = new_size;
-            }
-
-            for (size_t i = 0; i < decl_inst.instruction_count; i++)
-            {
-                ir_instructions[curr_index++] = decl_inst.instructions[i];
-                decl_inst.instructions[i]->base.parent = &(ir_function->base);
+                goto cleanup_and_return;
             }
-
-            deallocate(decl_inst.instructions);
             break;
         }
         default:
@@ -1686,25 +761,21 @@ ir_function_t *ir_handle_function(function_def_t *source_function)
         }
     }
 
-    ir_function->instruction_count = curr_index;
-    ir_function->body = ir_instructions;
-
+    symbol_map_destroy(&local_vregs);
     return ir_function;
 
 cleanup_and_return:
-    for (size_t i = 0; i < curr_index; i++)
+    symbol_map_destroy(&local_vregs);
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
     {
-        deallocate(ir_instructions[i]);
+        deallocate(INSTR_LIST_ENTRY(link, ir_instruction_t, link));
     }
-    deallocate(ir_instructions);
     deallocate(ir_identifier);
     deallocate(ir_function);
     DEBUG_NULL_RETURN("ir_handle_function");
     return NULL;
 }
 
-#undef NULL_INSTRUCTION_STRUCT
 #undef DEBUG_NULL_RETURN
-#undef MAX_TOTAL_INSTRUCTIONS
 
 #endif /* BF4D96C0_1C97_4F20_AB1B_168AC361CE92 */
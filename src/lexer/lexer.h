@@ -8,10 +8,19 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <string.h>
-
-#define MAX_FILE_SIZE 1000000
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../allocator/allocator.h"
+#include "../string_container/string_interner.h"
+#include "lexer_scan.h"
+
+#define SOURCE_READ_CHUNK 65536
 #define MAX_TOKEN_LENGTH 128
-#define MAX_TOKEN_NUMBER 1000000
+#define TOKEN_STREAM_MIN_CHUNK 256        // should always be a power of two
+#define TOKEN_STREAM_MAX_FIRST_CHUNK 65536 // cap on what a size hint can reserve up front
+#define TOKEN_STREAM_MAX_CHUNKS 32
 
 /*
 If an identifier is not defined in the current scope and is used in the program
@@ -64,47 +73,62 @@ typedef enum
     TOKEN_ERROR                         // For error reporting
 } token_type_t;
 
+/*
+Tokens don't carry a copy of their text; they describe a span of the source buffer.
+Identifiers are interned by the lexer and constants are converted while lexing, so
+the parser never needs to look at the characters again.
+*/
+
 typedef struct
 {
-    char value[MAX_TOKEN_LENGTH];
-    token_type_t type;
-    size_t line;
-    size_t column;
+    uint32_t offset; // start of the token in the source buffer
+    uint32_t line;
+    uint32_t column;
+    union
+    {
+        symbol_t symbol; // TOKEN_IDENTIFIER
+        int constant;    // TOKEN_CONSTANT
+    } value;
+    uint16_t length;
+    uint8_t type; // token_type_t
 } token_t;
 
+/*
+Tokens are stored in chunks that double in size, chunk k holding first_chunk << k tokens.
+Growing never moves tokens that were already pushed, so pointers into the stream stay
+valid, and the chunk holding any index can be found with a single count-leading-zeros.
+*/
+
 typedef struct
 {
-    const char *keyword;
-    token_type_t type;
-} keyword_map_t;
-
-static const keyword_map_t KEYWORDS[] = {
-    {"int", TOKEN_KEYWORD_INT},
-    {"void", TOKEN_KEYWORD_VOID},
-    {"return", TOKEN_KEYWORD_RETURN},
-    {"if", TOKEN_KEYWORD_IF},
-    {"else", TOKEN_KEYWORD_ELSE},
-    {"while", TOKEN_KEYWORD_WHILE},
-    {"for", TOKEN_KEYWORD_FOR},
-    {"break", TOKEN_KEYWORD_BREAK},
-    {"continue", TOKEN_KEYWORD_CONTINUE},
-    {"const", TOKEN_KEYWORD_CONST},
-};
-
-static const size_t KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+    token_t *chunks[TOKEN_STREAM_MAX_CHUNKS];
+    size_t chunk_count;
+    size_t first_chunk_log2;
+    size_t capacity;
+    size_t count;
+} token_stream_t;
+
+/*
+The source is mapped read-only whenever the input is a regular file, so the lexer
+works directly on the page cache. Pipes and stdin ("-") are read into a heap buffer.
+The view is not NUL terminated, the lexer is bounded by size instead.
+*/
 
 typedef struct
 {
-    token_t *tokens;
-    size_t count;
-} token_list_t;
+    const uint8_t *data;
+    size_t size;
+    bool mapped;
+} source_buffer_t;
 
 typedef struct
 {
     const uint8_t *input;
+    size_t size;
     size_t position;
     size_t line;
     size_t column;
+    bool failed; // set once an invalid token has been reported
 } lexer_t;
 
 static inline bool is_alpha(uint8_t c);
@@ -115,13 +139,19 @@ static inline bool is_whitespace(uint8_t c);
 static void advance_lexer(lexer_t *lexer);
 static void retreat_lexer(lexer_t *lexer);
 static inline uint8_t peek(lexer_t *lexer);
-static token_type_t check_keyword(const char *value);
-static bool add_token(token_list_t *list, const char *value, token_type_t type, size_t line, size_t column);
-static bool lex_identifier(lexer_t *lexer, token_list_t *list);
-static bool lex_number(lexer_t *lexer, token_list_t *list);
-static bool lex_symbol(lexer_t *lexer, token_list_t *list);
-static bool lex_source(const uint8_t *source, token_list_t *list);
-static uint8_t *read_source_file(const char *filename, size_t *file_size);
+static token_type_t check_keyword(const char *value, size_t length);
+bool token_stream_init(token_stream_t *stream, size_t size_hint);
+void token_stream_free(token_stream_t *stream);
+static token_t *token_stream_at(const token_stream_t *stream, size_t index);
+static bool add_token(token_stream_t *list, const token_t *token);
+static bool lex_identifier(lexer_t *lexer, token_t *token);
+static bool lex_number(lexer_t *lexer, token_t *token);
+static bool lex_symbol(lexer_t *lexer, token_t *token);
+static void init_lexer(lexer_t *lexer, const uint8_t *source, size_t size);
+static bool lex_next_token(lexer_t *lexer, token_t *token);
+bool lex_source(const uint8_t *source, size_t size, token_stream_t *list);
+static bool read_source_file(const char *filename, source_buffer_t *source);
+static void release_source_file(source_buffer_t *source);
 static const char *token_type_to_string(token_type_t type);
 
 static inline bool is_alpha(uint8_t c)
@@ -151,6 +181,11 @@ static inline bool is_whitespace(uint8_t c)
 
 static void advance_lexer(lexer_t *lexer)
 {
+    if (lexer->position >= lexer->size)
+    {
+        return;
+    }
+
     if (lexer->input[lexer->position] == '\n')
     {
         lexer->line++;
@@ -191,43 +226,157 @@ static void retreat_lexer(lexer_t *lexer)
 
 static inline uint8_t peek(lexer_t *lexer)
 {
+    if (lexer->position >= lexer->size)
+    {
+        return '\0';
+    }
     return lexer->input[lexer->position];
 }
 
-static token_type_t check_keyword(const char *value)
+#define KEYWORD_MATCH(keyword, token_type) \
+    return memcmp(value, keyword, sizeof(keyword) - 1) ? TOKEN_IDENTIFIER : token_type
+
+/*
+Keywords are told apart by their length and first character, which leaves at most one
+candidate to compare against. New keywords slot into the switch for their length.
+*/
+static token_type_t check_keyword(const char *value, size_t length)
 {
-    for (size_t i = 0; i < KEYWORD_COUNT; i++)
+    switch (length)
     {
-        if (strcmp(value, KEYWORDS[i].keyword) == 0)
+    case 2:
+        if (value[0] == 'i')
+        {
+            KEYWORD_MATCH("if", TOKEN_KEYWORD_IF);
+        }
+        break;
+    case 3:
+        switch (value[0])
+        {
+        case 'i':
+            KEYWORD_MATCH("int", TOKEN_KEYWORD_INT);
+        case 'f':
+            KEYWORD_MATCH("for", TOKEN_KEYWORD_FOR);
+        }
+        break;
+    case 4:
+        switch (value[0])
+        {
+        case 'v':
+            KEYWORD_MATCH("void", TOKEN_KEYWORD_VOID);
+        case 'e':
+            KEYWORD_MATCH("else", TOKEN_KEYWORD_ELSE);
+        }
+        break;
+    case 5:
+        switch (value[0])
         {
-            return KEYWORDS[i].type;
+        case 'w':
+            KEYWORD_MATCH("while", TOKEN_KEYWORD_WHILE);
+        case 'b':
+            KEYWORD_MATCH("break", TOKEN_KEYWORD_BREAK);
+        case 'c':
+            KEYWORD_MATCH("const", TOKEN_KEYWORD_CONST);
         }
+        break;
+    case 6:
+        if (value[0] == 'r')
+        {
+            KEYWORD_MATCH("return", TOKEN_KEYWORD_RETURN);
+        }
+        break;
+    case 8:
+        if (value[0] == 'c')
+        {
+            KEYWORD_MATCH("continue", TOKEN_KEYWORD_CONTINUE);
+        }
+        break;
     }
     return TOKEN_IDENTIFIER;
 }
 
-static bool add_token(token_list_t *list, const char *value, token_type_t type, size_t line, size_t column)
+#undef KEYWORD_MATCH
+
+bool token_stream_init(token_stream_t *stream, size_t size_hint)
 {
-    if (list->count >= MAX_TOKEN_NUMBER)
+    if (!stream)
     {
         return false;
     }
 
-    token_t *token = &list->tokens[list->count];
-    strncpy(token->value, value, MAX_TOKEN_LENGTH - 1);
-    token->value[MAX_TOKEN_LENGTH - 1] = '\0';
-    token->type = type;
-    token->line = line;
-    token->column = column;
+    memset(stream, 0, sizeof(*stream));
+
+    size_t expected = size_hint / 4;
+    size_t first_chunk = TOKEN_STREAM_MIN_CHUNK;
+    while (first_chunk < expected && first_chunk < TOKEN_STREAM_MAX_FIRST_CHUNK)
+    {
+        first_chunk <<= 1;
+    }
+
+    stream->first_chunk_log2 = (size_t)__builtin_ctzll(first_chunk);
+    return true;
+}
+
+void token_stream_free(token_stream_t *stream)
+{
+    if (!stream)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < stream->chunk_count; i++)
+    {
+        deallocate(stream->chunks[i]);
+        stream->chunks[i] = NULL;
+    }
+    stream->chunk_count = 0;
+    stream->capacity = 0;
+    stream->count = 0;
+}
+
+static token_t *token_stream_at(const token_stream_t *stream, size_t index)
+{
+    if (!stream || index >= stream->count)
+    {
+        return NULL;
+    }
+
+    // chunk k starts at index (2^k - 1) << first_chunk_log2
+    unsigned long long scaled = (unsigned long long)(index >> stream->first_chunk_log2) + 1;
+    size_t chunk = 63 - (size_t)__builtin_clzll(scaled);
+    size_t chunk_start = (((size_t)1 << chunk) - 1) << stream->first_chunk_log2;
+    return &stream->chunks[chunk][index - chunk_start];
+}
+
+static bool add_token(token_stream_t *list, const token_t *token)
+{
+    if (list->count >= list->capacity)
+    {
+        if (list->chunk_count >= TOKEN_STREAM_MAX_CHUNKS)
+        {
+            return false;
+        }
+
+        size_t chunk_size = (size_t)1 << (list->first_chunk_log2 + list->chunk_count);
+        token_t *chunk = (token_t *)allocate(sizeof(token_t) * chunk_size);
+        if (!chunk)
+        {
+            return false;
+        }
+
+        list->chunks[list->chunk_count++] = chunk;
+        list->capacity += chunk_size;
+    }
+
     list->count++;
+    *token_stream_at(list, list->count - 1) = *token;
     return true;
 }
 
-static bool lex_identifier(lexer_t *lexer, token_list_t *list)
+static bool lex_identifier(lexer_t *lexer, token_t *token)
 {
+    size_t start_pos = lexer->position;
     size_t start_column = lexer->column;
-    char buffer[MAX_TOKEN_LENGTH] = {0};
-    size_t length = 0;
     bool has_error = false;
 
     if (!is_identifier_start(peek(lexer)))
@@ -235,43 +384,66 @@ static bool lex_identifier(lexer_t *lexer, token_list_t *list)
         return false;
     }
 
-    while ((is_identifier_part(peek(lexer)) || is_digit(peek(lexer))) &&
-           length < MAX_TOKEN_LENGTH - 1)
+    // identifiers never span a newline, so the whole run can be skipped at once
+    size_t length = lexer_scanners.identifier(lexer->input + start_pos, lexer->size - start_pos);
+    if (length > MAX_TOKEN_LENGTH - 1)
     {
-        if (is_digit(peek(lexer)) && !has_error)
-        {
-            has_error = true;
-        }
-        buffer[length++] = peek(lexer);
+        length = MAX_TOKEN_LENGTH - 1;
+    }
+    lexer->position += length;
+    lexer->column += length;
+
+    while (length < MAX_TOKEN_LENGTH - 1 && (is_identifier_part(peek(lexer)) || is_digit(peek(lexer))))
+    {
+        has_error = has_error || is_digit(peek(lexer));
+        length++;
         advance_lexer(lexer);
     }
 
-    buffer[length] = '\0';
+    const char *text = (const char *)lexer->input + start_pos;
 
     if (has_error)
     {
-        fprintf(stderr, "Error at line %zu, column %zu: Invalid identifier '%s' (contains digits)\n",
-                lexer->line, start_column, buffer);
+        fprintf(stderr, "Error at line %zu, column %zu: Invalid identifier '%.*s' (contains digits)\n",
+                lexer->line, start_column, (int)length, text);
         return false;
     }
 
-    token_type_t type = check_keyword(buffer);
-    return add_token(list, buffer, type, lexer->line, start_column);
+    *token = (token_t){
+        .offset = (uint32_t)start_pos,
+        .line = (uint32_t)lexer->line,
+        .column = (uint32_t)start_column,
+        .length = (uint16_t)length,
+        .type = check_keyword(text, length),
+    };
+
+    if (token->type == TOKEN_IDENTIFIER)
+    {
+        token->value.symbol = intern_string(text, length);
+        if (token->value.symbol == SYMBOL_NONE)
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
-static bool lex_number(lexer_t *lexer, token_list_t *list)
+static bool lex_number(lexer_t *lexer, token_t *token)
 {
     size_t start_pos = lexer->position;
     size_t start_column = lexer->column;
-    char buffer[MAX_TOKEN_LENGTH] = {0};
     size_t length = 0;
     bool has_error = false;
+    bool is_negative = false;
     bool last_was_underscore = false;
+    unsigned int value = 0;
     char error_type[64] = {0};
 
     if (peek(lexer) == '-')
     {
-        buffer[length++] = peek(lexer);
+        is_negative = true;
+        length++;
         advance_lexer(lexer);
         if (!is_digit(peek(lexer)))
         {
@@ -285,11 +457,26 @@ static bool lex_number(lexer_t *lexer, token_list_t *list)
         return false;
     }
 
+    // the leading run of plain digits is by far the common case
+    size_t digits = lexer_scanners.digits(lexer->input + lexer->position, lexer->size - lexer->position);
+    if (length + digits > MAX_TOKEN_LENGTH - 1)
+    {
+        digits = MAX_TOKEN_LENGTH - 1 - length;
+    }
+    for (size_t i = 0; i < digits; i++)
+    {
+        value = value * 10 + (lexer->input[lexer->position + i] - '0');
+    }
+    lexer->position += digits;
+    lexer->column += digits;
+    length += digits;
+
     while (length < MAX_TOKEN_LENGTH - 1)
     {
         if (is_digit(peek(lexer)))
         {
-            buffer[length++] = peek(lexer);
+            value = value * 10 + (peek(lexer) - '0'); // wraps like the 32-bit int it becomes
+            length++;
             advance_lexer(lexer);
             last_was_underscore = false;
         }
@@ -300,7 +487,7 @@ static bool lex_number(lexer_t *lexer, token_list_t *list)
                 has_error = true;
                 strncpy(error_type, "Cannot have consecutive underscores in number", sizeof(error_type) - 1);
             }
-            buffer[length++] = peek(lexer);
+            length++;
             advance_lexer(lexer);
             last_was_underscore = true;
         }
@@ -311,7 +498,7 @@ static bool lex_number(lexer_t *lexer, token_list_t *list)
                 has_error = true;
                 strncpy(error_type, "Invalid number format", sizeof(error_type) - 1);
             }
-            buffer[length++] = peek(lexer);
+            length++;
             advance_lexer(lexer);
         }
         else
@@ -320,8 +507,6 @@ static bool lex_number(lexer_t *lexer, token_list_t *list)
         }
     }
 
-    buffer[length] = '\0';
-
     if (last_was_underscore && !has_error)
     {
         has_error = true;
@@ -330,17 +515,26 @@ static bool lex_number(lexer_t *lexer, token_list_t *list)
 
     if (has_error)
     {
-        fprintf(stderr, "Error at line %zu, column %zu: %s '%s'\n",
-                lexer->line, start_column, error_type, buffer);
+        fprintf(stderr, "Error at line %zu, column %zu: %s '%.*s'\n",
+                lexer->line, start_column, error_type, (int)length, (const char *)lexer->input + start_pos);
         return false;
     }
 
-    return add_token(list, buffer, TOKEN_CONSTANT, lexer->line, start_column);
+    *token = (token_t){
+        .offset = (uint32_t)start_pos,
+        .line = (uint32_t)lexer->line,
+        .column = (uint32_t)start_column,
+        .value.constant = (int)(is_negative ? 0u - value : value),
+        .length = (uint16_t)length,
+        .type = TOKEN_CONSTANT,
+    };
+    return true;
 }
 
-static bool lex_symbol(lexer_t *lexer, token_list_t *list)
+static bool lex_symbol(lexer_t *lexer, token_t *token)
 {
-    char symbol[3] = {peek(lexer), '\0', '\0'}; // Support for two-character operators
+    size_t start_pos = lexer->position;
+    size_t start_column = lexer->column;
     token_type_t type;
     bool valid = true;
 
@@ -374,7 +568,6 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer);
         if (peek(lexer) == '&')
         {
-            symbol[1] = '&';
             type = TOKEN_OPERATOR_LOGICAL_AND;
         }
         else
@@ -387,7 +580,6 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer);
         if (peek(lexer) == '|')
         {
-            symbol[1] = '|';
             type = TOKEN_OPERATOR_LOGICAL_OR;
         }
         else
@@ -403,7 +595,6 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer);
         if (peek(lexer) == '-')
         {
-            symbol[1] = '-';
             type = TOKEN_OPERATOR_DECREMENT;
         }
         else
@@ -422,7 +613,6 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer); // Lookahead for ==
         if (peek(lexer) == '=')
         {
-            symbol[1] = '=';
             type = TOKEN_OPERATOR_EQUAL;
         }
         else
@@ -435,7 +625,6 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer); // Lookahead for !=
         if (peek(lexer) == '=')
         {
-            symbol[1] = '=';
             type = TOKEN_OPERATOR_NOT_EQUAL;
         }
         else
@@ -448,12 +637,10 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer); // Lookahead for <=
         if (peek(lexer) == '=')
         {
-            symbol[1] = '=';
             type = TOKEN_OPERATOR_LESS_EQUAL;
         }
         else if (peek(lexer) == '<')
         {
-            symbol[1] = '<';
             type = TOKEN_OPERATOR_BITWISE_LEFT_SHIFT;
         }
         else
@@ -466,12 +653,10 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
         advance_lexer(lexer); // Lookahead for >=
         if (peek(lexer) == '=')
         {
-            symbol[1] = '=';
             type = TOKEN_OPERATOR_GREATER_EQUAL;
         }
         else if (peek(lexer) == '>')
         {
-            symbol[1] = '>';
             type = TOKEN_OPERATOR_BITWISE_RIGHT_SHIFT;
         }
         else
@@ -487,108 +672,240 @@ static bool lex_symbol(lexer_t *lexer, token_list_t *list)
     if (valid)
     {
         advance_lexer(lexer);
-        return add_token(list, symbol, type, lexer->line, lexer->column - 1);
+        *token = (token_t){
+            .offset = (uint32_t)start_pos,
+            .line = (uint32_t)lexer->line,
+            .column = (uint32_t)start_column,
+            .length = (uint16_t)(lexer->position - start_pos),
+            .type = type,
+        };
+        return true;
     }
     return false;
 }
 
-static bool lex_source(const uint8_t *source, token_list_t *list)
+static void init_lexer(lexer_t *lexer, const uint8_t *source, size_t size)
+{
+    lexer->input = source;
+    lexer->size = size;
+    lexer->position = 0;
+    lexer->line = 1;
+    lexer->column = 1;
+    lexer->failed = false;
+    init_lexer_scanners();
+}
+
+// Produces the next token on demand, false means end of input or an error (see lexer->failed)
+static bool lex_next_token(lexer_t *lexer, token_t *token)
 {
-    lexer_t lexer = {
-        .input = source,
-        .position = 0,
-        .line = 1,
-        .column = 1};
+    if (lexer->failed)
+    {
+        return false;
+    }
+
+    whitespace_run_t run = lexer_scanners.whitespace(lexer->input + lexer->position, lexer->size - lexer->position);
+    if (run.newlines)
+    {
+        lexer->line += run.newlines;
+        lexer->column = 1 + run.length - run.line_start;
+    }
+    else
+    {
+        lexer->column += run.length;
+    }
+    lexer->position += run.length;
 
-    while (peek(&lexer) != '\0')
+    if (lexer->position >= lexer->size)
     {
-        if (is_whitespace(peek(&lexer)))
+        return false;
+    }
+
+    bool ok;
+    if (is_identifier_start(peek(lexer)))
+    {
+        ok = lex_identifier(lexer, token);
+    }
+    else if (is_digit(peek(lexer)))
+    {
+        ok = lex_number(lexer, token);
+    }
+    else
+    {
+        ok = lex_symbol(lexer, token);
+        if (!ok)
         {
-            advance_lexer(&lexer);
-            continue;
+            fprintf(stderr, "Error at line %zu, column %zu: Invalid character '%c'\n",
+                    lexer->line, lexer->column, peek(lexer));
         }
+    }
+
+    lexer->failed = !ok;
+    return ok;
+}
+
+// Lexes the whole source up front, which the token dump of test/main.c needs; the compiler pulls tokens with lex_next_token
+bool lex_source(const uint8_t *source, size_t size, token_stream_t *list)
+{
+    lexer_t lexer;
+    init_lexer(&lexer, source, size);
 
-        if (is_identifier_start(peek(&lexer)))
+    token_t token;
+    while (lex_next_token(&lexer, &token))
+    {
+        if (!add_token(list, &token))
         {
-            if (!lex_identifier(&lexer, list))
-            {
-                return false;
-            }
-            continue;
+            return false;
         }
+    }
+
+    return !lexer.failed;
+}
+
+static bool read_source_stream(int fd, source_buffer_t *source)
+{
+    size_t capacity = SOURCE_READ_CHUNK;
+    size_t size = 0;
+    uint8_t *buffer = (uint8_t *)malloc(capacity);
+    if (!buffer)
+    {
+        perror("malloc");
+        return false;
+    }
 
-        if (is_digit(peek(&lexer)))
+    for (;;)
+    {
+        if (size == capacity)
         {
-            if (!lex_number(&lexer, list))
+            // token offsets are 32 bits wide, same limit as a mapped file
+            if (capacity > UINT32_MAX)
+            {
+                fprintf(stderr, "Source input is larger than 4 GB\n");
+                free(buffer);
+                return false;
+            }
+            capacity *= 2;
+            uint8_t *grown = (uint8_t *)realloc(buffer, capacity);
+            if (!grown)
             {
+                perror("realloc");
+                free(buffer);
                 return false;
             }
-            continue;
+            buffer = grown;
         }
 
-        if (!lex_symbol(&lexer, list))
+        ssize_t read_size = read(fd, buffer + size, capacity - size);
+        if (read_size < 0)
         {
-            fprintf(stderr, "Error at line %zu, column %zu: Invalid character '%c'\n",
-                    lexer.line, lexer.column, peek(&lexer));
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("read");
+            free(buffer);
             return false;
         }
+        if (read_size == 0)
+        {
+            break;
+        }
+        size += (size_t)read_size;
     }
 
+    source->data = buffer;
+    source->size = size;
+    source->mapped = false;
     return true;
 }
 
-static uint8_t *read_source_file(const char *filename, size_t *file_size)
+static bool read_source_file(const char *filename, source_buffer_t *source)
 {
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    if (!filename || !source)
     {
-        perror("fopen");
-        return NULL;
+        return false;
     }
 
-    if (fseek(file, 0, SEEK_END) != 0)
+    if (!strcmp(filename, "-"))
     {
-        perror("fseek");
-        fclose(file);
-        return NULL;
+        return read_source_stream(STDIN_FILENO, source);
     }
 
-    long size = ftell(file);
-    if (size < 0)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
     {
-        fprintf(stderr, "File size error or file too large\n");
-        fclose(file);
-        return NULL;
+        perror("open");
+        return false;
     }
 
-    if (fseek(file, 0, SEEK_SET) != 0)
+    struct stat info;
+    if (fstat(fd, &info) != 0)
     {
-        perror("fseek");
-        fclose(file);
-        return NULL;
+        perror("fstat");
+        close(fd);
+        return false;
     }
 
-    uint8_t *buffer = (uint8_t *)malloc(size + 1);
-    if (!buffer)
+    if (!S_ISREG(info.st_mode))
     {
-        perror("malloc");
-        fclose(file);
-        return NULL;
+        bool ok = read_source_stream(fd, source);
+        close(fd);
+        return ok;
     }
 
-    size_t read_size = fread(buffer, 1, size, file);
-    if (read_size != (size_t)size)
+    // token offsets are 32 bits wide
+    if ((uint64_t)info.st_size > UINT32_MAX)
     {
-        perror("fread");
-        free(buffer);
-        fclose(file);
-        return NULL;
+        fprintf(stderr, "Source file '%s' is larger than 4 GB\n", filename);
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size == 0)
+    {
+        source->data = NULL;
+        source->size = 0;
+        source->mapped = false;
+        close(fd);
+        return true;
+    }
+
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        bool ok = read_source_stream(fd, source);
+        close(fd);
+        return ok;
+    }
+
+    // the lexer walks the file front to back exactly once
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+    close(fd);
+
+    source->data = (const uint8_t *)data;
+    source->size = (size_t)info.st_size;
+    source->mapped = true;
+    return true;
+}
+
+static void release_source_file(source_buffer_t *source)
+{
+    if (!source)
+    {
+        return;
+    }
+
+    if (source->mapped)
+    {
+        munmap((void *)source->data, source->size);
+    }
+    else
+    {
+        free((void *)source->data);
     }
 
-    buffer[size] = '\0';
-    *file_size = size;
-    fclose(file);
-    return buffer;
+    source->data = NULL;
+    source->size = 0;
+    source->mapped = false;
 }
 
 static const char *token_type_to_string(token_type_t type)
@@ -0,0 +1,289 @@
+#ifndef A7C3E91F_2D64_4B0A_8E5D_61F4B2C9D037
+#define A7C3E91F_2D64_4B0A_8E5D_61F4B2C9D037
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEXER_SCAN_X86
+#endif
+
+/*
+Run scanners used by the lexer to skip whitespace, identifier and digit runs in bulk.
+Every scanner returns how many leading bytes of data[0..length) belong to the class.
+The best implementation for the running CPU is picked once, the scalar versions are
+the fallback and also finish the tail that is too short for a full vector.
+*/
+
+#define SCAN_WHITESPACE 0x1
+#define SCAN_IDENTIFIER 0x2 // [a-zA-Z_]
+#define SCAN_DIGIT 0x4
+
+static const uint8_t SCAN_CLASS[256] = {
+    [' '] = SCAN_WHITESPACE,
+    ['\t'] = SCAN_WHITESPACE,
+    ['\n'] = SCAN_WHITESPACE,
+    ['\r'] = SCAN_WHITESPACE,
+    ['a' ... 'z'] = SCAN_IDENTIFIER,
+    ['A' ... 'Z'] = SCAN_IDENTIFIER,
+    ['_'] = SCAN_IDENTIFIER,
+    ['0' ... '9'] = SCAN_DIGIT,
+};
+
+typedef struct
+{
+    size_t length;
+    size_t newlines;
+    size_t line_start; // offset just past the last newline, valid when newlines > 0
+} whitespace_run_t;
+
+typedef struct
+{
+    whitespace_run_t (*whitespace)(const uint8_t *data, size_t length);
+    size_t (*identifier)(const uint8_t *data, size_t length); // [a-zA-Z_], digits end the run
+    size_t (*digits)(const uint8_t *data, size_t length);
+} lexer_scanners_t;
+
+lexer_scanners_t lexer_scanners = {0};
+
+static void init_lexer_scanners(void);
+
+static inline size_t scan_class_scalar(const uint8_t *data, size_t length, uint8_t mask)
+{
+    size_t i = 0;
+    while (i < length && (SCAN_CLASS[data[i]] & mask))
+    {
+        i++;
+    }
+    return i;
+}
+
+static whitespace_run_t scan_whitespace_scalar(const uint8_t *data, size_t length)
+{
+    whitespace_run_t run = {0};
+    while (run.length < length && (SCAN_CLASS[data[run.length]] & SCAN_WHITESPACE))
+    {
+        if (data[run.length] == '\n')
+        {
+            run.newlines++;
+            run.line_start = run.length + 1;
+        }
+        run.length++;
+    }
+    return run;
+}
+
+static size_t scan_identifier_scalar(const uint8_t *data, size_t length)
+{
+    return scan_class_scalar(data, length, SCAN_IDENTIFIER);
+}
+
+static size_t scan_digits_scalar(const uint8_t *data, size_t length)
+{
+    return scan_class_scalar(data, length, SCAN_DIGIT);
+}
+
+#ifdef LEXER_SCAN_X86
+
+// Bytes in [lo, hi] compare true, using a signed compare after shifting lo down to -128
+#define SCAN_RANGE_SSE2(v, lo, hi) \
+    _mm_cmplt_epi8(_mm_add_epi8((v), _mm_set1_epi8((char)(0x80 - (lo)))), _mm_set1_epi8((char)(0x80 + (hi) - (lo) + 1)))
+#define SCAN_RANGE_AVX2(v, lo, hi) \
+    _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + (hi) - (lo) + 1)), _mm256_add_epi8((v), _mm256_set1_epi8((char)(0x80 - (lo)))))
+
+__attribute__((target("sse2"))) static inline __m128i scan_identifier_mask_sse2(__m128i v)
+{
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha = SCAN_RANGE_SSE2(lower, 'a', 'z');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(alpha, underscore);
+}
+
+__attribute__((target("sse2"))) static whitespace_run_t scan_whitespace_sse2(const uint8_t *data, size_t length)
+{
+    whitespace_run_t run = {0};
+    while (run.length + 16 <= length)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + run.length));
+        __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), newline));
+
+        uint32_t other = ~(uint32_t)_mm_movemask_epi8(space) & 0xFFFF;
+        size_t count = other ? (size_t)__builtin_ctz(other) : 16;
+        uint32_t newlines = (uint32_t)_mm_movemask_epi8(newline) & ((1u << count) - 1);
+
+        if (newlines)
+        {
+            run.newlines += (size_t)__builtin_popcount(newlines);
+            run.line_start = run.length + 32 - (size_t)__builtin_clz(newlines);
+        }
+
+        run.length += count;
+        if (count < 16)
+        {
+            return run;
+        }
+    }
+
+    whitespace_run_t tail = scan_whitespace_scalar(data + run.length, length - run.length);
+    if (tail.newlines)
+    {
+        run.newlines += tail.newlines;
+        run.line_start = run.length + tail.line_start;
+    }
+    run.length += tail.length;
+    return run;
+}
+
+__attribute__((target("sse2"))) static size_t scan_identifier_sse2(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+    while (i + 16 <= length)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        uint32_t other = ~(uint32_t)_mm_movemask_epi8(scan_identifier_mask_sse2(v)) & 0xFFFF;
+        if (other)
+        {
+            return i + (size_t)__builtin_ctz(other);
+        }
+        i += 16;
+    }
+    return i + scan_identifier_scalar(data + i, length - i);
+}
+
+__attribute__((target("sse2"))) static size_t scan_digits_sse2(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+    while (i + 16 <= length)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        uint32_t other = ~(uint32_t)_mm_movemask_epi8(SCAN_RANGE_SSE2(v, '0', '9')) & 0xFFFF;
+        if (other)
+        {
+            return i + (size_t)__builtin_ctz(other);
+        }
+        i += 16;
+    }
+    return i + scan_digits_scalar(data + i, length - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i scan_identifier_mask_avx2(__m256i v)
+{
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i alpha = SCAN_RANGE_AVX2(lower, 'a', 'z');
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(alpha, underscore);
+}
+
+__attribute__((target("avx2"))) static whitespace_run_t scan_whitespace_avx2(const uint8_t *data, size_t length)
+{
+    whitespace_run_t run = {0};
+    while (run.length + 32 <= length)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + run.length));
+        __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), newline));
+
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(space);
+        size_t count = other ? (size_t)__builtin_ctz(other) : 32;
+        uint32_t newlines = (uint32_t)_mm256_movemask_epi8(newline);
+        if (count < 32)
+        {
+            newlines &= (1u << count) - 1;
+        }
+
+        if (newlines)
+        {
+            run.newlines += (size_t)__builtin_popcount(newlines);
+            run.line_start = run.length + 32 - (size_t)__builtin_clz(newlines);
+        }
+
+        run.length += count;
+        if (count < 32)
+        {
+            return run;
+        }
+    }
+
+    whitespace_run_t tail = scan_whitespace_sse2(data + run.length, length - run.length);
+    if (tail.newlines)
+    {
+        run.newlines += tail.newlines;
+        run.line_start = run.length + tail.line_start;
+    }
+    run.length += tail.length;
+    return run;
+}
+
+__attribute__((target("avx2"))) static size_t scan_identifier_avx2(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+    while (i + 32 <= length)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(scan_identifier_mask_avx2(v));
+        if (other)
+        {
+            return i + (size_t)__builtin_ctz(other);
+        }
+        i += 32;
+    }
+    return i + scan_identifier_sse2(data + i, length - i);
+}
+
+__attribute__((target("avx2"))) static size_t scan_digits_avx2(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+    while (i + 32 <= length)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(SCAN_RANGE_AVX2(v, '0', '9'));
+        if (other)
+        {
+            return i + (size_t)__builtin_ctz(other);
+        }
+        i += 32;
+    }
+    return i + scan_digits_sse2(data + i, length - i);
+}
+
+#undef SCAN_RANGE_SSE2
+#undef SCAN_RANGE_AVX2
+
+#endif /* LEXER_SCAN_X86 */
+
+static void init_lexer_scanners(void)
+{
+    if (lexer_scanners.whitespace)
+    {
+        return;
+    }
+
+    lexer_scanners.whitespace = scan_whitespace_scalar;
+    lexer_scanners.identifier = scan_identifier_scalar;
+    lexer_scanners.digits = scan_digits_scalar;
+
+#ifdef LEXER_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        lexer_scanners.whitespace = scan_whitespace_avx2;
+        lexer_scanners.identifier = scan_identifier_avx2;
+        lexer_scanners.digits = scan_digits_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        lexer_scanners.whitespace = scan_whitespace_sse2;
+        lexer_scanners.identifier = scan_identifier_sse2;
+        lexer_scanners.digits = scan_digits_sse2;
+    }
+#endif
+}
+
+#endif /* A7C3E91F_2D64_4B0A_8E5D_61F4B2C9D037 */
@@ -0,0 +1,356 @@
+#ifndef D5A80F3B_92C4_4E17_A6D9_1B47E3C08F62
+#define D5A80F3B_92C4_4E17_A6D9_1B47E3C08F62
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "../ir_gen/ir_generation.h"
+#include "cfg.h"
+#include "def_use.h"
+#include "dce.h"
+
+/*
+Branch simplification for the code the short-circuit operators leave behind, run once the
+function is out of SSA form. Three rewrites repeat until none applies:
+
+- A boolean that is set to a constant on the way into a block whose only work is testing it
+  is not materialized at all: the predecessor jumps straight to the side the test would pick.
+  This only happens when that test is the one place the boolean is read.
+- A jump to a block holding nothing but labels and another jump, or only labels, goes to
+  where that chain ends instead.
+- A jump to the instruction that follows anyway is deleted.
+
+Blocks that nothing jumps into any more are emptied right away, so they do not get in the way
+of the last rewrite.
+*/
+
+size_t thread_label_count = 0;
+
+bool ir_simplify_branches(ir_cfg_t *cfg, bool *changed);
+
+static ir_identifier_t *ir_branch_target(ir_instruction_t *instruction)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_JUMP:
+        return instruction->instruction.jmp_instr.target;
+    case IR_INSTR_JUMP_IF_ZERO:
+    case IR_INSTR_JUMP_IF_NOT_ZERO:
+        // jz and jnz share their layout
+        return instruction->instruction.jz_instr.target;
+    default:
+        return NULL;
+    }
+}
+
+static bool ir_branch_only_labels(ir_basic_block_t *block)
+{
+    INSTR_LIST_FOR_EACH(link, &block->instructions)
+    {
+        if (INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type != IR_INSTR_LABEL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A label opening block b, one is added when it has none; SYMBOL_NONE when out of memory
+static symbol_t ir_branch_label(ir_cfg_t *cfg, uint32_t b)
+{
+    ir_instruction_t *first = ir_block_first(&cfg->blocks[b]);
+    if (first && first->type == IR_INSTR_LABEL)
+    {
+        return first->instruction.label_instr.identifier->name;
+    }
+
+    symbol_t name = intern_generated_name(".L_thread", &thread_label_count);
+    ir_instruction_t *label = ir_new_instruction(cfg->function, IR_INSTR_LABEL);
+    symbol_map_entry_t *entry = name != SYMBOL_NONE ? symbol_map_insert(&cfg->label_blocks, name) : NULL;
+    if (!label || !entry)
+    {
+        return SYMBOL_NONE;
+    }
+
+    label->instruction.label_instr.identifier = ir_new_identifier(name, &label->base);
+    if (!label->instruction.label_instr.identifier)
+    {
+        return SYMBOL_NONE;
+    }
+    entry->value.integer = (int)b;
+    instr_list_push_front(&cfg->blocks[b].instructions, &label->link);
+    return name;
+}
+
+// Marks a block whose destination is being looked up, so that a cycle of empty blocks ends the walk
+#define IR_BRANCH_ON_PATH (IR_CFG_NO_BLOCK - 1)
+
+// The block control moves on to when block b does nothing but pass it on, IR_CFG_NO_BLOCK otherwise
+static uint32_t ir_branch_passes_to(ir_cfg_t *cfg, uint32_t b)
+{
+    ir_basic_block_t *block = &cfg->blocks[b];
+    ir_instruction_t *first = NULL;
+    INSTR_LIST_FOR_EACH(link, &block->instructions)
+    {
+        first = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        if (first->type != IR_INSTR_LABEL)
+        {
+            break;
+        }
+        first = NULL;
+    }
+
+    if (!first)
+    {
+        return block->layout_next;
+    }
+    if (first->type == IR_INSTR_JUMP && first == ir_block_last(block))
+    {
+        return ir_cfg_block_of_label(cfg, first->instruction.jmp_instr.target->name);
+    }
+    return IR_CFG_NO_BLOCK;
+}
+
+/*
+Where control really ends up when it enters block b, skipping blocks that only pass it on.
+destinations holds the answer for every block looked up so far in this round, IR_CFG_NO_BLOCK
+where there is none yet; every block on the walk gets the answer, so each chain is walked once.
+path is scratch space for block_count entries.
+*/
+static uint32_t ir_branch_destination(ir_cfg_t *cfg, uint32_t b, uint32_t *destinations, uint32_t *path)
+{
+    uint32_t path_count = 0;
+    uint32_t end = b;
+    while (destinations[end] != IR_BRANCH_ON_PATH)
+    {
+        if (destinations[end] != IR_CFG_NO_BLOCK)
+        {
+            end = destinations[end];
+            break;
+        }
+
+        uint32_t next = ir_branch_passes_to(cfg, end);
+        if (next == IR_CFG_NO_BLOCK)
+        {
+            break;
+        }
+        destinations[end] = IR_BRANCH_ON_PATH;
+        path[path_count++] = end;
+        end = next;
+    }
+
+    destinations[end] = end;
+    for (uint32_t i = 0; i < path_count; i++)
+    {
+        destinations[path[i]] = end;
+    }
+    return end;
+}
+
+// Sends predecessors that set the tested boolean to a constant straight to the chosen side
+static bool ir_branch_fuse_tests(ir_cfg_t *cfg, bool *changed)
+{
+    ir_def_use_t def_use;
+    if (!ir_def_use_build(cfg, &def_use))
+    {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t b = 0; b < cfg->block_count && ok; b++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[b];
+        ir_instruction_t *test = ir_block_last(block);
+        if (!test || (test->type != IR_INSTR_JUMP_IF_ZERO && test->type != IR_INSTR_JUMP_IF_NOT_ZERO))
+        {
+            continue;
+        }
+
+        ir_value_t *condition = test->instruction.jz_instr.condition;
+        bool only_test = true;
+        INSTR_LIST_FOR_EACH(link, &block->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            only_test = only_test && (instruction == test || instruction->type == IR_INSTR_LABEL);
+        }
+        if (!only_test || condition->type != IR_VAL_VARIABLE ||
+            ir_def_use_count(&def_use, condition->value.variable.vreg) != 1)
+        {
+            continue;
+        }
+
+        for (uint32_t p = 0; p < cfg->blocks[b].predecessors.count && ok; p++)
+        {
+            ir_basic_block_t *predecessor = &cfg->blocks[cfg->blocks[b].predecessors.items[p]];
+            ir_instruction_t *last = ir_block_last(predecessor);
+            instr_link_t *copy_link = NULL;
+            if (last && last->type == IR_INSTR_JUMP && ir_cfg_block_of_label(cfg, last->instruction.jmp_instr.target->name) == b)
+            {
+                copy_link = instr_list_prev(&predecessor->instructions, &last->link);
+            }
+            else if (last && !ir_instruction_is_terminator(last) && predecessor->layout_next == b)
+            {
+                copy_link = &last->link;
+                last = NULL;
+            }
+            if (!copy_link)
+            {
+                continue;
+            }
+
+            ir_instruction_t *copy = INSTR_LIST_ENTRY(copy_link, ir_instruction_t, link);
+            if (copy->type != IR_INSTR_COPY || copy->instruction.copy_instr.source->type != IR_VAL_CONSTANT_INT ||
+                copy->instruction.copy_instr.destination->value.variable.vreg != condition->value.variable.vreg)
+            {
+                continue;
+            }
+
+            int constant_int = copy->instruction.copy_instr.source->value.constant_int;
+            bool taken = (constant_int == 0) == (test->type == IR_INSTR_JUMP_IF_ZERO);
+            uint32_t destination = taken ? ir_cfg_block_of_label(cfg, test->instruction.jz_instr.target->name)
+                                         : cfg->blocks[b].layout_next;
+            if (destination == IR_CFG_NO_BLOCK)
+            {
+                continue;
+            }
+
+            // the pointers into cfg->blocks stay valid, adding a label does not add blocks
+            symbol_t label = ir_branch_label(cfg, destination);
+            if (label == SYMBOL_NONE)
+            {
+                ok = false;
+                break;
+            }
+
+            instr_list_remove(&predecessor->instructions, copy_link);
+            if (last)
+            {
+                last->instruction.jmp_instr.target->name = label;
+            }
+            else
+            {
+                ir_instruction_t *jump = ir_new_instruction(cfg->function, IR_INSTR_JUMP);
+                if (!jump || !(jump->instruction.jmp_instr.target = ir_new_identifier(label, &jump->base)))
+                {
+                    ok = false;
+                    break;
+                }
+                instr_list_push_back(&predecessor->instructions, &jump->link);
+            }
+            *changed = true;
+        }
+    }
+
+    ir_def_use_free(&def_use);
+    return ok;
+}
+
+static bool ir_branch_thread_jumps(ir_cfg_t *cfg, bool *changed)
+{
+    uint32_t *destinations = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *path = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    if (!destinations || !path)
+    {
+        deallocate(destinations);
+        deallocate(path);
+        return false;
+    }
+    memset(destinations, 0xff, cfg->block_count * sizeof(uint32_t));
+
+    bool ok = true;
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        ir_instruction_t *last = ir_block_last(&cfg->blocks[b]);
+        ir_identifier_t *target = last ? ir_branch_target(last) : NULL;
+        if (!target)
+        {
+            continue;
+        }
+
+        uint32_t current = ir_cfg_block_of_label(cfg, target->name);
+        uint32_t destination = current == IR_CFG_NO_BLOCK ? current : ir_branch_destination(cfg, current, destinations, path);
+        if (destination == current)
+        {
+            continue;
+        }
+
+        symbol_t label = ir_branch_label(cfg, destination);
+        if (label == SYMBOL_NONE)
+        {
+            ok = false;
+            break;
+        }
+        target->name = label;
+        *changed = true;
+    }
+
+    deallocate(destinations);
+    deallocate(path);
+    return ok;
+}
+
+static void ir_branch_remove_jumps_to_next(ir_cfg_t *cfg, bool *changed)
+{
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[b];
+        ir_instruction_t *last = ir_block_last(block);
+        ir_identifier_t *target = last ? ir_branch_target(last) : NULL;
+        if (!target)
+        {
+            continue;
+        }
+
+        uint32_t destination = ir_cfg_block_of_label(cfg, target->name);
+        uint32_t next = block->layout_next;
+        while (next != IR_CFG_NO_BLOCK && next != destination && ir_branch_only_labels(&cfg->blocks[next]))
+        {
+            next = cfg->blocks[next].layout_next;
+        }
+
+        if (next != IR_CFG_NO_BLOCK && next == destination)
+        {
+            instr_list_remove(&block->instructions, &last->link);
+            *changed = true;
+        }
+    }
+}
+
+bool ir_simplify_branches(ir_cfg_t *cfg, bool *changed)
+{
+    for (bool progress = true; progress;)
+    {
+        progress = false;
+        if (!ir_branch_fuse_tests(cfg, &progress) || !ir_branch_thread_jumps(cfg, &progress))
+        {
+            return false;
+        }
+
+        if (progress && (!ir_cfg_compute_edges(cfg) || !ir_cfg_compute_dominators(cfg)))
+        {
+            return false;
+        }
+        if (ir_dce_remove_unreachable(cfg))
+        {
+            progress = true;
+            if (!ir_cfg_compute_edges(cfg) || !ir_cfg_compute_dominators(cfg))
+            {
+                return false;
+            }
+        }
+
+        bool removed = false;
+        ir_branch_remove_jumps_to_next(cfg, &removed);
+        if (removed && (!ir_cfg_compute_edges(cfg) || !ir_cfg_compute_dominators(cfg)))
+        {
+            return false;
+        }
+        progress |= removed;
+        *changed |= progress;
+    }
+    return true;
+}
+
+#endif /* D5A80F3B_92C4_4E17_A6D9_1B47E3C08F62 */
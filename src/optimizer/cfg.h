@@ -0,0 +1,705 @@
+#ifndef A7D3E9F2_4C61_4B08_8E5A_D1F06B3C7A92
+#define A7D3E9F2_4C61_4B08_8E5A_D1F06B3C7A92
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "../hash_table/symbol_map.h"
+#include "../instr_list/instr_list.h"
+
+/*
+Control-flow graph of an IR function. Building it moves the body into per-block instruction
+lists: a block starts at a label or after a jump or return. Blocks are chained in layout
+order, falling off the end of one enters the next in the chain, and new blocks can be linked
+in anywhere. Passes edit the blocks in place and ir_cfg_linearize splices them back into the
+function body in layout order.
+
+Edges are derived from each block's last instruction. Dominators use the iterative algorithm
+of Cooper, Harvey and Kennedy over reverse post-order, which converges in a couple of sweeps
+on the graphs we produce; dominance frontiers are collected from the join points afterwards.
+After changing any jump or label call ir_cfg_compute_edges and ir_cfg_compute_dominators
+again.
+*/
+
+#define IR_CFG_NO_BLOCK UINT32_MAX
+
+typedef struct
+{
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} ir_block_list_t;
+
+typedef struct
+{
+    uint32_t id;
+    instr_list_t instructions;
+    uint32_t layout_prev; // IR_CFG_NO_BLOCK at either end of the chain
+    uint32_t layout_next;
+
+    uint32_t successors[2]; // branch target first, fall-through second
+    uint32_t successor_count;
+    ir_block_list_t predecessors;
+
+    uint32_t rpo_number; // IR_CFG_NO_BLOCK when unreachable from the entry
+    uint32_t idom;       // IR_CFG_NO_BLOCK for the entry and for unreachable blocks
+    ir_block_list_t dom_children;
+    ir_block_list_t frontier;
+    uint32_t dom_pre; // dominator tree pre/post numbers, for constant time dominance queries
+    uint32_t dom_post;
+} ir_basic_block_t;
+
+typedef struct
+{
+    ir_function_t *function;
+    ir_basic_block_t *blocks; // blocks[0] is the entry
+    uint32_t block_count;
+    uint32_t block_capacity;
+    uint32_t layout_tail;
+    uint32_t *rpo; // reachable blocks in reverse post-order
+    uint32_t rpo_count;
+    symbol_map_t label_blocks; // label -> block it starts
+} ir_cfg_t;
+
+bool ir_cfg_build(ir_function_t *ir_function, ir_cfg_t *cfg);
+ir_basic_block_t *ir_cfg_insert_block_after(ir_cfg_t *cfg, uint32_t after);
+void ir_cfg_unlink_block(ir_cfg_t *cfg, uint32_t b);
+bool ir_cfg_compute_edges(ir_cfg_t *cfg);
+bool ir_cfg_compute_dominators(ir_cfg_t *cfg);
+void ir_cfg_linearize(ir_cfg_t *cfg);
+void ir_cfg_free(ir_cfg_t *cfg);
+uint32_t ir_cfg_block_of_label(const ir_cfg_t *cfg, symbol_t label);
+bool ir_cfg_dominates(const ir_cfg_t *cfg, uint32_t dominator, uint32_t block);
+void ir_cfg_print(const ir_cfg_t *cfg, FILE *stream);
+
+static inline ir_instruction_t *ir_block_first(ir_basic_block_t *block)
+{
+    instr_link_t *link = instr_list_first(&block->instructions);
+    return link ? INSTR_LIST_ENTRY(link, ir_instruction_t, link) : NULL;
+}
+
+static inline ir_instruction_t *ir_block_last(ir_basic_block_t *block)
+{
+    instr_link_t *link = instr_list_last(&block->instructions);
+    return link ? INSTR_LIST_ENTRY(link, ir_instruction_t, link) : NULL;
+}
+
+static inline bool ir_instruction_is_terminator(const ir_instruction_t *instruction)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_RETURN:
+    case IR_INSTR_JUMP:
+    case IR_INSTR_JUMP_IF_ZERO:
+    case IR_INSTR_JUMP_IF_NOT_ZERO:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Number of operands instruction reads, constants included
+static inline uint32_t ir_instruction_use_count(const ir_instruction_t *instruction)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_RETURN:
+    case IR_INSTR_UNARY:
+    case IR_INSTR_COPY:
+    case IR_INSTR_JUMP_IF_ZERO:
+    case IR_INSTR_JUMP_IF_NOT_ZERO:
+        return 1;
+    case IR_INSTR_BINARY:
+        return 2;
+    case IR_INSTR_PHI:
+        return instruction->instruction.phi_instr.argument_count;
+    default:
+        return 0;
+    }
+}
+
+static inline ir_value_t *ir_instruction_use(ir_instruction_t *instruction, uint32_t index)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_RETURN:
+        return instruction->instruction.return_instr.value;
+    case IR_INSTR_UNARY:
+        return instruction->instruction.unary_instr.source;
+    case IR_INSTR_BINARY:
+        return index ? instruction->instruction.binary_instr.right : instruction->instruction.binary_instr.left;
+    case IR_INSTR_COPY:
+        return instruction->instruction.copy_instr.source;
+    case IR_INSTR_JUMP_IF_ZERO:
+        return instruction->instruction.jz_instr.condition;
+    case IR_INSTR_JUMP_IF_NOT_ZERO:
+        return instruction->instruction.jnz_instr.condition;
+    case IR_INSTR_PHI:
+        return instruction->instruction.phi_instr.arguments[index];
+    default:
+        return NULL;
+    }
+}
+
+// The variable instruction writes, NULL for jumps, labels and returns
+static inline ir_value_t *ir_instruction_definition(ir_instruction_t *instruction)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_UNARY:
+        return instruction->instruction.unary_instr.destination;
+    case IR_INSTR_BINARY:
+        return instruction->instruction.binary_instr.destination;
+    case IR_INSTR_COPY:
+        return instruction->instruction.copy_instr.destination;
+    case IR_INSTR_PHI:
+        return instruction->instruction.phi_instr.destination;
+    default:
+        return NULL;
+    }
+}
+
+static bool ir_block_list_push(ir_block_list_t *list, uint32_t block)
+{
+    if (list->count == list->capacity)
+    {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 4;
+        uint32_t *items = (uint32_t *)allocate(capacity * sizeof(uint32_t));
+        if (!items)
+        {
+            return false;
+        }
+
+        if (list->items)
+        {
+            memcpy(items, list->items, list->count * sizeof(uint32_t));
+            deallocate(list->items);
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count++] = block;
+    return true;
+}
+
+static bool ir_block_list_contains(const ir_block_list_t *list, uint32_t block)
+{
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        if (list->items[i] == block)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ir_block_list_free(ir_block_list_t *list)
+{
+    deallocate(list->items);
+    memset(list, 0, sizeof(ir_block_list_t));
+}
+
+// Appends a block to the array, it is not part of the layout chain yet
+static ir_basic_block_t *ir_cfg_new_block(ir_cfg_t *cfg)
+{
+    if (cfg->block_count == cfg->block_capacity)
+    {
+        uint32_t capacity = cfg->block_capacity ? cfg->block_capacity * 2 : 16;
+        ir_basic_block_t *blocks = (ir_basic_block_t *)allocate(capacity * sizeof(ir_basic_block_t));
+        if (!blocks)
+        {
+            return NULL;
+        }
+
+        // the instruction lists point back at their own sentinel, so they are moved rather than copied
+        for (uint32_t i = 0; i < cfg->block_count; i++)
+        {
+            blocks[i] = cfg->blocks[i];
+            instr_list_init(&blocks[i].instructions);
+            instr_list_splice_back(&blocks[i].instructions, &cfg->blocks[i].instructions);
+        }
+        deallocate(cfg->blocks);
+        cfg->blocks = blocks;
+        cfg->block_capacity = capacity;
+    }
+
+    ir_basic_block_t *block = &cfg->blocks[cfg->block_count];
+    memset(block, 0, sizeof(ir_basic_block_t));
+    block->id = cfg->block_count++;
+    instr_list_init(&block->instructions);
+    block->rpo_number = IR_CFG_NO_BLOCK;
+    block->idom = IR_CFG_NO_BLOCK;
+    block->layout_prev = IR_CFG_NO_BLOCK;
+    block->layout_next = IR_CFG_NO_BLOCK;
+    return block;
+}
+
+// New empty block placed right after block after in the layout; edges are not updated
+ir_basic_block_t *ir_cfg_insert_block_after(ir_cfg_t *cfg, uint32_t after)
+{
+    ir_basic_block_t *block = ir_cfg_new_block(cfg);
+    if (!block)
+    {
+        return NULL;
+    }
+
+    ir_basic_block_t *previous = &cfg->blocks[after];
+    block->layout_prev = after;
+    block->layout_next = previous->layout_next;
+    if (previous->layout_next != IR_CFG_NO_BLOCK)
+    {
+        cfg->blocks[previous->layout_next].layout_prev = block->id;
+    }
+    else
+    {
+        cfg->layout_tail = block->id;
+    }
+    previous->layout_next = block->id;
+    return block;
+}
+
+// Takes block b out of the layout chain, it keeps its id but nothing falls into it or out of it
+void ir_cfg_unlink_block(ir_cfg_t *cfg, uint32_t b)
+{
+    ir_basic_block_t *block = &cfg->blocks[b];
+    if (block->layout_prev != IR_CFG_NO_BLOCK)
+    {
+        cfg->blocks[block->layout_prev].layout_next = block->layout_next;
+    }
+    if (block->layout_next != IR_CFG_NO_BLOCK)
+    {
+        cfg->blocks[block->layout_next].layout_prev = block->layout_prev;
+    }
+    else
+    {
+        cfg->layout_tail = block->layout_prev;
+    }
+    block->layout_prev = IR_CFG_NO_BLOCK;
+    block->layout_next = IR_CFG_NO_BLOCK;
+}
+
+bool ir_cfg_build(ir_function_t *ir_function, ir_cfg_t *cfg)
+{
+    if (!ir_function || !cfg)
+    {
+        return false;
+    }
+
+    memset(cfg, 0, sizeof(ir_cfg_t));
+    cfg->function = ir_function;
+    if (!symbol_map_init(&cfg->label_blocks, 16) || !ir_cfg_new_block(cfg))
+    {
+        return false;
+    }
+
+    uint32_t current = 0;
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        ir_basic_block_t *block = &cfg->blocks[current];
+
+        // a label opens a block unless the current one is still empty
+        bool starts_block = instruction->type == IR_INSTR_LABEL && !instr_list_empty(&block->instructions) &&
+                            ir_block_last(block)->type != IR_INSTR_LABEL;
+        ir_instruction_t *last = ir_block_last(block);
+        if (starts_block || (last && ir_instruction_is_terminator(last)))
+        {
+            block = ir_cfg_insert_block_after(cfg, current);
+            if (!block)
+            {
+                return false;
+            }
+            current = block->id;
+        }
+
+        instr_list_remove(&ir_function->body, link);
+        instr_list_push_back(&block->instructions, link);
+    }
+
+    return ir_cfg_compute_edges(cfg) && ir_cfg_compute_dominators(cfg);
+}
+
+uint32_t ir_cfg_block_of_label(const ir_cfg_t *cfg, symbol_t label)
+{
+    symbol_map_entry_t *entry = symbol_map_find(&cfg->label_blocks, label);
+    return entry ? (uint32_t)entry->value.integer : IR_CFG_NO_BLOCK;
+}
+
+static bool ir_cfg_add_edge(ir_cfg_t *cfg, uint32_t from, uint32_t to)
+{
+    if (to == IR_CFG_NO_BLOCK)
+    {
+        return false;
+    }
+
+    ir_basic_block_t *block = &cfg->blocks[from];
+    for (uint32_t i = 0; i < block->successor_count; i++)
+    {
+        if (block->successors[i] == to)
+        {
+            return true; // jz to the very next block
+        }
+    }
+
+    block->successors[block->successor_count++] = to;
+    return ir_block_list_push(&cfg->blocks[to].predecessors, from);
+}
+
+bool ir_cfg_compute_edges(ir_cfg_t *cfg)
+{
+    symbol_map_clear(&cfg->label_blocks);
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[i];
+        block->successor_count = 0;
+        block->predecessors.count = 0;
+
+        INSTR_LIST_FOR_EACH(link, &block->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (instruction->type != IR_INSTR_LABEL)
+            {
+                break;
+            }
+
+            symbol_map_entry_t *entry = symbol_map_insert(&cfg->label_blocks, instruction->instruction.label_instr.identifier->name);
+            if (!entry)
+            {
+                return false;
+            }
+            entry->value.integer = (int)i;
+        }
+    }
+
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        ir_instruction_t *last = ir_block_last(&cfg->blocks[i]);
+        bool falls_through = true;
+        bool linked = true;
+
+        if (last)
+        {
+            switch (last->type)
+            {
+            case IR_INSTR_RETURN:
+                falls_through = false;
+                break;
+            case IR_INSTR_JUMP:
+                falls_through = false;
+                linked = ir_cfg_add_edge(cfg, i, ir_cfg_block_of_label(cfg, last->instruction.jmp_instr.target->name));
+                break;
+            case IR_INSTR_JUMP_IF_ZERO:
+                linked = ir_cfg_add_edge(cfg, i, ir_cfg_block_of_label(cfg, last->instruction.jz_instr.target->name));
+                break;
+            case IR_INSTR_JUMP_IF_NOT_ZERO:
+                linked = ir_cfg_add_edge(cfg, i, ir_cfg_block_of_label(cfg, last->instruction.jnz_instr.target->name));
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (!linked)
+        {
+            return false;
+        }
+
+        uint32_t next = cfg->blocks[i].layout_next;
+        if (falls_through && next != IR_CFG_NO_BLOCK && !ir_cfg_add_edge(cfg, i, next))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool ir_cfg_compute_rpo(ir_cfg_t *cfg)
+{
+    deallocate(cfg->rpo);
+    cfg->rpo = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *stack = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *next_successor = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    if (!cfg->rpo || !stack || !next_successor)
+    {
+        deallocate(stack);
+        deallocate(next_successor);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        cfg->blocks[i].rpo_number = IR_CFG_NO_BLOCK;
+        next_successor[i] = 0;
+    }
+
+    // blocks are numbered in post-order as they are finished, then the order is reversed
+    uint32_t depth = 0, finished = 0;
+    stack[depth++] = 0;
+    cfg->blocks[0].rpo_number = 0; // marks the block as visited until it gets its real number
+
+    while (depth)
+    {
+        ir_basic_block_t *block = &cfg->blocks[stack[depth - 1]];
+        if (next_successor[block->id] < block->successor_count)
+        {
+            uint32_t successor = block->successors[next_successor[block->id]++];
+            if (cfg->blocks[successor].rpo_number == IR_CFG_NO_BLOCK)
+            {
+                cfg->blocks[successor].rpo_number = 0;
+                stack[depth++] = successor;
+            }
+            continue;
+        }
+
+        cfg->rpo[finished++] = block->id;
+        depth--;
+    }
+
+    for (uint32_t i = 0; i < finished / 2; i++)
+    {
+        uint32_t swap = cfg->rpo[i];
+        cfg->rpo[i] = cfg->rpo[finished - 1 - i];
+        cfg->rpo[finished - 1 - i] = swap;
+    }
+
+    for (uint32_t i = 0; i < finished; i++)
+    {
+        cfg->blocks[cfg->rpo[i]].rpo_number = i;
+    }
+    cfg->rpo_count = finished;
+
+    deallocate(stack);
+    deallocate(next_successor);
+    return true;
+}
+
+static uint32_t ir_cfg_intersect(const ir_cfg_t *cfg, uint32_t first, uint32_t second)
+{
+    while (first != second)
+    {
+        while (cfg->blocks[first].rpo_number > cfg->blocks[second].rpo_number)
+        {
+            first = cfg->blocks[first].idom;
+        }
+        while (cfg->blocks[second].rpo_number > cfg->blocks[first].rpo_number)
+        {
+            second = cfg->blocks[second].idom;
+        }
+    }
+    return first;
+}
+
+static void ir_cfg_number_dom_tree(ir_cfg_t *cfg, uint32_t *stack, uint32_t *next_child)
+{
+    uint32_t depth = 0, counter = 0;
+    stack[depth++] = 0;
+    next_child[0] = 0;
+    cfg->blocks[0].dom_pre = counter++;
+
+    while (depth)
+    {
+        ir_basic_block_t *block = &cfg->blocks[stack[depth - 1]];
+        if (next_child[block->id] < block->dom_children.count)
+        {
+            uint32_t child = block->dom_children.items[next_child[block->id]++];
+            next_child[child] = 0;
+            cfg->blocks[child].dom_pre = counter++;
+            stack[depth++] = child;
+            continue;
+        }
+
+        block->dom_post = counter++;
+        depth--;
+    }
+}
+
+bool ir_cfg_compute_dominators(ir_cfg_t *cfg)
+{
+    if (!ir_cfg_compute_rpo(cfg))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[i];
+        block->idom = IR_CFG_NO_BLOCK;
+        block->dom_children.count = 0;
+        block->frontier.count = 0;
+        block->dom_pre = IR_CFG_NO_BLOCK;
+        block->dom_post = IR_CFG_NO_BLOCK;
+    }
+
+    cfg->blocks[0].idom = 0; // the entry is its own dominator while iterating
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (uint32_t i = 1; i < cfg->rpo_count; i++)
+        {
+            ir_basic_block_t *block = &cfg->blocks[cfg->rpo[i]];
+            uint32_t new_idom = IR_CFG_NO_BLOCK;
+
+            for (uint32_t p = 0; p < block->predecessors.count; p++)
+            {
+                uint32_t predecessor = block->predecessors.items[p];
+                if (cfg->blocks[predecessor].idom == IR_CFG_NO_BLOCK)
+                {
+                    continue; // unreachable or not processed yet
+                }
+                new_idom = new_idom == IR_CFG_NO_BLOCK ? predecessor : ir_cfg_intersect(cfg, predecessor, new_idom);
+            }
+
+            if (block->idom != new_idom)
+            {
+                block->idom = new_idom;
+                changed = true;
+            }
+        }
+    }
+    cfg->blocks[0].idom = IR_CFG_NO_BLOCK;
+
+    for (uint32_t i = 1; i < cfg->rpo_count; i++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[cfg->rpo[i]];
+        if (!ir_block_list_push(&cfg->blocks[block->idom].dom_children, block->id))
+        {
+            return false;
+        }
+    }
+
+    // a join point is in the frontier of every block on the way up from a predecessor to its idom
+    for (uint32_t i = 0; i < cfg->rpo_count; i++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[cfg->rpo[i]];
+        if (block->predecessors.count < 2 && block->id != 0)
+        {
+            continue;
+        }
+
+        for (uint32_t p = 0; p < block->predecessors.count; p++)
+        {
+            uint32_t runner = block->predecessors.items[p];
+            if (cfg->blocks[runner].rpo_number == IR_CFG_NO_BLOCK)
+            {
+                continue;
+            }
+
+            while (runner != IR_CFG_NO_BLOCK && runner != block->idom)
+            {
+                ir_block_list_t *frontier = &cfg->blocks[runner].frontier;
+                if (!ir_block_list_contains(frontier, block->id) && !ir_block_list_push(frontier, block->id))
+                {
+                    return false;
+                }
+                runner = cfg->blocks[runner].idom;
+            }
+        }
+    }
+
+    uint32_t *stack = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *next_child = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    if (!stack || !next_child)
+    {
+        deallocate(stack);
+        deallocate(next_child);
+        return false;
+    }
+
+    ir_cfg_number_dom_tree(cfg, stack, next_child);
+    deallocate(stack);
+    deallocate(next_child);
+    return true;
+}
+
+// Unreachable blocks neither dominate nor are dominated
+bool ir_cfg_dominates(const ir_cfg_t *cfg, uint32_t dominator, uint32_t block)
+{
+    const ir_basic_block_t *outer = &cfg->blocks[dominator];
+    const ir_basic_block_t *inner = &cfg->blocks[block];
+    if (outer->rpo_number == IR_CFG_NO_BLOCK || inner->rpo_number == IR_CFG_NO_BLOCK)
+    {
+        return false;
+    }
+
+    return outer->dom_pre <= inner->dom_pre && inner->dom_post <= outer->dom_post;
+}
+
+// Moves every block back into the function body in layout order, the cfg is left empty.
+// Whatever a failed build had not moved out of the body yet stays behind the blocks.
+void ir_cfg_linearize(ir_cfg_t *cfg)
+{
+    if (!cfg->function)
+    {
+        return;
+    }
+
+    instr_list_t body;
+    instr_list_init(&body);
+    for (uint32_t i = 0; i < cfg->block_count && i != IR_CFG_NO_BLOCK; i = cfg->blocks[i].layout_next)
+    {
+        instr_list_splice_back(&body, &cfg->blocks[i].instructions);
+    }
+
+    instr_list_splice_back(&body, &cfg->function->body);
+    instr_list_splice_back(&cfg->function->body, &body);
+}
+
+void ir_cfg_free(ir_cfg_t *cfg)
+{
+    if (!cfg)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        ir_block_list_free(&cfg->blocks[i].predecessors);
+        ir_block_list_free(&cfg->blocks[i].dom_children);
+        ir_block_list_free(&cfg->blocks[i].frontier);
+    }
+
+    deallocate(cfg->blocks);
+    deallocate(cfg->rpo);
+    symbol_map_destroy(&cfg->label_blocks);
+    memset(cfg, 0, sizeof(ir_cfg_t));
+}
+
+static void ir_cfg_print_list(const char *title, const uint32_t *items, uint32_t count, FILE *stream)
+{
+    fprintf(stream, " %s:", title);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        fprintf(stream, " %u", items[i]);
+    }
+}
+
+void ir_cfg_print(const ir_cfg_t *cfg, FILE *stream)
+{
+    fprintf(stream, "cfg: %u blocks, %u reachable\n", cfg->block_count, cfg->rpo_count);
+    for (uint32_t i = 0; i < cfg->block_count; i++)
+    {
+        const ir_basic_block_t *block = &cfg->blocks[i];
+        fprintf(stream, "  bb%u: %zu instructions", block->id, block->instructions.count);
+        if (block->layout_next != IR_CFG_NO_BLOCK)
+        {
+            fprintf(stream, " next: %u", block->layout_next);
+        }
+        ir_cfg_print_list("preds", block->predecessors.items, block->predecessors.count, stream);
+        ir_cfg_print_list("succs", block->successors, block->successor_count, stream);
+        if (block->idom != IR_CFG_NO_BLOCK)
+        {
+            fprintf(stream, " idom: %u", block->idom);
+        }
+        ir_cfg_print_list("df", block->frontier.items, block->frontier.count, stream);
+        fprintf(stream, "\n");
+    }
+}
+
+#endif /* A7D3E9F2_4C61_4B08_8E5A_D1F06B3C7A92 */
@@ -0,0 +1,316 @@
+#ifndef E3B86F41_2A9C_4D57_B0E8_7C14A5D92F63
+#define E3B86F41_2A9C_4D57_B0E8_7C14A5D92F63
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "cfg.h"
+
+/*
+Evaluates unary and binary instructions whose operands are known at compile time. Within a
+block, a variable that was just given a constant is replaced by that constant in later uses,
+so chains like a = 2 * 3; b = a + 4 fold all the way. Knowledge does not cross block
+boundaries, the sparse pass does that. Conditional jumps on a constant become plain jumps or
+disappear.
+
+Arithmetic wraps around like the generated code does. Anything C leaves undefined and that
+would trap or depend on the target at run time (division by zero, INT_MIN / -1, shift counts
+outside 0..31) is left alone.
+*/
+
+bool ir_eval_unary(ir_unary_operator_type_t op, int operand, int *result);
+bool ir_eval_binary(ir_binary_operator_type_t op, int left, int right, int *result);
+bool ir_resolve_branch(ir_basic_block_t *block, ir_instruction_t *instruction, int condition);
+bool ir_fold_constants(ir_cfg_t *cfg, bool *changed);
+
+bool ir_eval_unary(ir_unary_operator_type_t op, int operand, int *result)
+{
+    switch (op)
+    {
+    case IR_UNARY_BITWISE_COMPLEMENT:
+        *result = ~operand;
+        return true;
+    case IR_UNARY_NEGATE:
+        *result = (int)(0u - (uint32_t)operand);
+        return true;
+    case IR_UNARY_NOT:
+        *result = !operand;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ir_eval_binary(ir_binary_operator_type_t op, int left, int right, int *result)
+{
+    uint32_t l = (uint32_t)left, r = (uint32_t)right;
+
+    switch (op)
+    {
+    case IR_BINARY_MULTIPLY:
+        *result = (int)(l * r);
+        return true;
+    case IR_BINARY_DIVIDE:
+    case IR_BINARY_REM:
+        if (right == 0 || (left == INT_MIN && right == -1))
+        {
+            return false;
+        }
+        *result = op == IR_BINARY_DIVIDE ? left / right : left % right;
+        return true;
+    case IR_BINARY_ADD:
+        *result = (int)(l + r);
+        return true;
+    case IR_BINARY_SUBTRACT:
+        *result = (int)(l - r);
+        return true;
+    case IR_BINARY_BITWISE_LEFT_SHIFT:
+    case IR_BINARY_BITWISE_RIGHT_SHIFT:
+        if (right < 0 || right >= 32)
+        {
+            return false;
+        }
+        // sal and sar, the right shift of a negative value keeps its sign
+        *result = op == IR_BINARY_BITWISE_LEFT_SHIFT ? (int)(l << right) : left >> right;
+        return true;
+    case IR_BINARY_LESS_THAN:
+        *result = left < right;
+        return true;
+    case IR_BINARY_LESS_THAN_EQUAL:
+        *result = left <= right;
+        return true;
+    case IR_BINARY_GREATER_THAN:
+        *result = left > right;
+        return true;
+    case IR_BINARY_GREATER_THAN_EQUAL:
+        *result = left >= right;
+        return true;
+    case IR_BINARY_EQUAL:
+        *result = left == right;
+        return true;
+    case IR_BINARY_NOT_EQUAL:
+        *result = left != right;
+        return true;
+    case IR_BINARY_BITWISE_AND:
+        *result = (int)(l & r);
+        return true;
+    case IR_BINARY_BITWISE_XOR:
+        *result = (int)(l ^ r);
+        return true;
+    case IR_BINARY_BITWISE_OR:
+        *result = (int)(l | r);
+        return true;
+    case IR_BINARY_LOGICAL_AND:
+        *result = left && right;
+        return true;
+    case IR_BINARY_LOGICAL_OR:
+        *result = left || right;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Turns jz or jnz on a known condition into a jump, or drops it; true when the branch is taken
+bool ir_resolve_branch(ir_basic_block_t *block, ir_instruction_t *instruction, int condition)
+{
+    // jz and jnz share their layout
+    ir_identifier_t *target = instruction->instruction.jz_instr.target;
+    bool taken = (condition == 0) == (instruction->type == IR_INSTR_JUMP_IF_ZERO);
+    if (taken)
+    {
+        instruction->type = IR_INSTR_JUMP;
+        instruction->instruction.jmp_instr.target = target;
+    }
+    else
+    {
+        instr_list_remove(&block->instructions, &instruction->link);
+    }
+    return taken;
+}
+
+typedef struct
+{
+    int *values;
+    uint32_t *known_in; // block id + 1 while values[vreg] holds, so a new block forgets everything at once
+    uint32_t stamp;
+} ir_fold_state_t;
+
+static void ir_fold_use(ir_fold_state_t *state, ir_value_t *value, bool *changed)
+{
+    if (value && value->type == IR_VAL_VARIABLE && state->known_in[value->value.variable.vreg] == state->stamp)
+    {
+        int constant_int = state->values[value->value.variable.vreg];
+        value->type = IR_VAL_CONSTANT_INT;
+        value->value.constant_int = constant_int;
+        *changed = true;
+    }
+}
+
+static void ir_fold_define(ir_fold_state_t *state, const ir_value_t *destination, const ir_value_t *source)
+{
+    uint32_t vreg = destination->value.variable.vreg;
+    if (source && source->type == IR_VAL_CONSTANT_INT)
+    {
+        state->values[vreg] = source->value.constant_int;
+        state->known_in[vreg] = state->stamp;
+    }
+    else
+    {
+        state->known_in[vreg] = 0;
+    }
+}
+
+// Rewrites a unary or binary instruction into destination = constant_int
+static bool ir_fold_into_copy(ir_instruction_t *instruction, ir_value_t *destination, int constant_int)
+{
+    ir_value_t *source = (ir_value_t *)allocate(sizeof(ir_value_t));
+    if (!source)
+    {
+        return false;
+    }
+
+    source->base.type = IR_NODE_VALUE;
+    source->base.parent = &instruction->base;
+    source->type = IR_VAL_CONSTANT_INT;
+    source->value.constant_int = constant_int;
+
+    instruction->type = IR_INSTR_COPY;
+    instruction->instruction.copy_instr.source = source;
+    instruction->instruction.copy_instr.destination = destination;
+    return true;
+}
+
+static bool ir_fold_instruction(ir_fold_state_t *state, ir_basic_block_t *block, ir_instruction_t *instruction,
+                                bool *changed, bool *edges_changed)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_RETURN:
+        ir_fold_use(state, instruction->instruction.return_instr.value, changed);
+        return true;
+    case IR_INSTR_COPY:
+    {
+        ir_instruction_copy_t *copy = &instruction->instruction.copy_instr;
+        ir_fold_use(state, copy->source, changed);
+        ir_fold_define(state, copy->destination, copy->source);
+        return true;
+    }
+    case IR_INSTR_UNARY:
+    {
+        ir_instruction_unary_t unary = instruction->instruction.unary_instr;
+        ir_fold_use(state, unary.source, changed);
+
+        int result;
+        if (unary.source->type == IR_VAL_CONSTANT_INT &&
+            ir_eval_unary(unary.unary_operator->unary_op, unary.source->value.constant_int, &result))
+        {
+            if (!ir_fold_into_copy(instruction, unary.destination, result))
+            {
+                return false;
+            }
+            *changed = true;
+        }
+
+        ir_fold_define(state, unary.destination,
+                       instruction->type == IR_INSTR_COPY ? instruction->instruction.copy_instr.source : NULL);
+        return true;
+    }
+    case IR_INSTR_BINARY:
+    {
+        ir_instruction_binary_t binary = instruction->instruction.binary_instr;
+        ir_fold_use(state, binary.left, changed);
+        ir_fold_use(state, binary.right, changed);
+
+        int result;
+        if (binary.left->type == IR_VAL_CONSTANT_INT && binary.right->type == IR_VAL_CONSTANT_INT &&
+            ir_eval_binary(binary.binary_operator->operator, binary.left->value.constant_int,
+                           binary.right->value.constant_int, &result))
+        {
+            if (!ir_fold_into_copy(instruction, binary.destination, result))
+            {
+                return false;
+            }
+            *changed = true;
+        }
+
+        ir_fold_define(state, binary.destination,
+                       instruction->type == IR_INSTR_COPY ? instruction->instruction.copy_instr.source : NULL);
+        return true;
+    }
+    case IR_INSTR_JUMP_IF_ZERO:
+    case IR_INSTR_JUMP_IF_NOT_ZERO:
+    {
+        ir_value_t *condition = instruction->instruction.jz_instr.condition;
+        ir_fold_use(state, condition, changed);
+        if (condition->type != IR_VAL_CONSTANT_INT)
+        {
+            return true;
+        }
+
+        ir_resolve_branch(block, instruction, condition->value.constant_int);
+        *changed = true;
+        *edges_changed = true;
+        return true;
+    }
+    default:
+    {
+        ir_value_t *destination = ir_instruction_definition(instruction);
+        if (destination)
+        {
+            ir_fold_define(state, destination, NULL);
+        }
+        return true;
+    }
+    }
+}
+
+bool ir_fold_constants(ir_cfg_t *cfg, bool *changed)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    size_t count = vreg_count ? vreg_count : 1;
+
+    ir_fold_state_t state = {
+        .values = (int *)allocate(count * sizeof(int)),
+        .known_in = (uint32_t *)allocate(count * sizeof(uint32_t)),
+        .stamp = 0,
+    };
+    if (!state.values || !state.known_in)
+    {
+        deallocate(state.values);
+        deallocate(state.known_in);
+        return false;
+    }
+    memset(state.known_in, 0, count * sizeof(uint32_t));
+
+    bool edges_changed = false;
+    bool ok = true;
+    for (uint32_t i = 0; i < cfg->block_count && ok; i++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[i];
+        state.stamp = i + 1;
+
+        INSTR_LIST_FOR_EACH(link, &block->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (!ir_fold_instruction(&state, block, instruction, changed, &edges_changed))
+            {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    deallocate(state.values);
+    deallocate(state.known_in);
+
+    if (ok && edges_changed)
+    {
+        ok = ir_cfg_compute_edges(cfg) && ir_cfg_compute_dominators(cfg);
+    }
+    return ok;
+}
+
+#endif /* E3B86F41_2A9C_4D57_B0E8_7C14A5D92F63 */
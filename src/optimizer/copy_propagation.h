@@ -0,0 +1,199 @@
+#ifndef E09B4C73_5A21_4D8E_B6F4_2C71A3E8D590
+#define E09B4C73_5A21_4D8E_B6F4_2C71A3E8D590
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "cfg.h"
+#include "def_use.h"
+
+/*
+Copy propagation and copy coalescing.
+
+Propagation runs on SSA form, where a copy d = s means d and s hold the same value wherever d
+is visible, so every use of d can read s instead. Chains of copies are followed to their
+first source. The copies themselves are left for dead code elimination.
+
+Coalescing runs after SSA form is gone and targets the pattern the generator and the phi
+copies leave behind: t = a op b followed by x = t, with t read nowhere else. The computation
+then writes x directly and the copy goes away, as long as x is not touched in between. The
+backend lowers x = a op b as mov x, a; op x, b, so x must not be the right operand b.
+*/
+
+bool ir_propagate_copies(ir_cfg_t *cfg, bool *changed);
+bool ir_coalesce_copies(ir_cfg_t *cfg, bool *changed);
+
+bool ir_propagate_copies(ir_cfg_t *cfg, bool *changed)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    const ir_value_t **sources = (const ir_value_t **)allocate((vreg_count ? vreg_count : 1) * sizeof(ir_value_t *));
+    if (!sources)
+    {
+        return false;
+    }
+    memset(sources, 0, (vreg_count ? vreg_count : 1) * sizeof(ir_value_t *));
+
+    // a definition dominates its uses, so in reverse postorder the source of a copy is settled first
+    for (uint32_t r = 0; r < cfg->rpo_count; r++)
+    {
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[cfg->rpo[r]].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (instruction->type != IR_INSTR_COPY)
+            {
+                continue;
+            }
+
+            const ir_value_t *source = instruction->instruction.copy_instr.source;
+            if (source->type == IR_VAL_VARIABLE && sources[source->value.variable.vreg])
+            {
+                source = sources[source->value.variable.vreg];
+            }
+            sources[instruction->instruction.copy_instr.destination->value.variable.vreg] = source;
+        }
+    }
+
+    for (uint32_t r = 0; r < cfg->rpo_count; r++)
+    {
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[cfg->rpo[r]].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type != IR_VAL_VARIABLE || !sources[use->value.variable.vreg])
+                {
+                    continue;
+                }
+
+                const ir_value_t *source = sources[use->value.variable.vreg];
+                use->type = source->type;
+                use->value = source->value;
+                *changed = true;
+            }
+        }
+    }
+
+    deallocate(sources);
+    return true;
+}
+
+static bool ir_coalesce_touches(ir_instruction_t *instruction, uint32_t vreg)
+{
+    ir_value_t *destination = ir_instruction_definition(instruction);
+    if (destination && destination->value.variable.vreg == vreg)
+    {
+        return true;
+    }
+
+    for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+    {
+        ir_value_t *use = ir_instruction_use(instruction, u);
+        if (use->type == IR_VAL_VARIABLE && use->value.variable.vreg == vreg)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The instruction computing source for the copy at link, when it can write destination itself
+static ir_instruction_t *ir_coalesce_candidate(ir_basic_block_t *block, instr_link_t *link, uint32_t source,
+                                               uint32_t destination)
+{
+    for (instr_link_t *previous = instr_list_prev(&block->instructions, link); previous;
+         previous = instr_list_prev(&block->instructions, previous))
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(previous, ir_instruction_t, link);
+        ir_value_t *definition = ir_instruction_definition(instruction);
+        if (!definition || definition->value.variable.vreg != source)
+        {
+            if (ir_coalesce_touches(instruction, destination))
+            {
+                return NULL;
+            }
+            continue;
+        }
+
+        if (instruction->type == IR_INSTR_BINARY)
+        {
+            const ir_value_t *right = instruction->instruction.binary_instr.right;
+            if (right->type == IR_VAL_VARIABLE && right->value.variable.vreg == destination)
+            {
+                return NULL;
+            }
+        }
+        return instruction->type == IR_INSTR_PHI ? NULL : instruction;
+    }
+    return NULL;
+}
+
+bool ir_coalesce_copies(ir_cfg_t *cfg, bool *changed)
+{
+    ir_def_use_t def_use;
+    if (!ir_def_use_build(cfg, &def_use))
+    {
+        return false;
+    }
+
+    uint32_t *definition_count = (uint32_t *)allocate((def_use.vreg_count ? def_use.vreg_count : 1) * sizeof(uint32_t));
+    if (!definition_count)
+    {
+        ir_def_use_free(&def_use);
+        return false;
+    }
+    memset(definition_count, 0, (def_use.vreg_count ? def_use.vreg_count : 1) * sizeof(uint32_t));
+
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            ir_value_t *destination = ir_instruction_definition(INSTR_LIST_ENTRY(link, ir_instruction_t, link));
+            if (destination)
+            {
+                definition_count[destination->value.variable.vreg]++;
+            }
+        }
+    }
+
+    // retargeting trades one definition of the copy destination for another, the counts stay valid
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[b];
+        INSTR_LIST_FOR_EACH(link, &block->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (instruction->type != IR_INSTR_COPY || instruction->instruction.copy_instr.source->type != IR_VAL_VARIABLE)
+            {
+                continue;
+            }
+
+            ir_value_t *destination = instruction->instruction.copy_instr.destination;
+            uint32_t source = instruction->instruction.copy_instr.source->value.variable.vreg;
+            if (source == destination->value.variable.vreg || definition_count[source] != 1 ||
+                ir_def_use_count(&def_use, source) != 1)
+            {
+                continue;
+            }
+
+            ir_instruction_t *computation = ir_coalesce_candidate(block, link, source, destination->value.variable.vreg);
+            if (!computation)
+            {
+                continue;
+            }
+
+            ir_value_t *target = ir_instruction_definition(computation);
+            target->value.variable = destination->value.variable;
+            instr_list_remove(&block->instructions, link);
+            *changed = true;
+        }
+    }
+
+    deallocate(definition_count);
+    ir_def_use_free(&def_use);
+    return true;
+}
+
+#endif /* E09B4C73_5A21_4D8E_B6F4_2C71A3E8D590 */
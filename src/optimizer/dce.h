@@ -0,0 +1,404 @@
+#ifndef B3E97C52_1D46_4A8F_9B20_6F8D4C1A7E35
+#define B3E97C52_1D46_4A8F_9B20_6F8D4C1A7E35
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "cfg.h"
+
+/*
+Dead code elimination driven by register liveness. Most registers are temporaries written and
+read inside one block, so liveness across blocks is only worked out for the registers a block
+reads before writing them. Each of those is followed backwards from the blocks reading it,
+through their predecessors, until every path has reached a block writing it; the blocks passed
+on the way have it live on entry. That costs time and memory in proportion to the live ranges
+rather than to blocks times registers. Each block is then walked backwards from its live-out
+set, and a copy, unary, binary or phi whose destination is not live at that point is deleted.
+Deleting a use can kill the definition it read in an earlier block, so both steps repeat until
+nothing more goes away.
+
+Blocks that cannot be reached from the entry are emptied and taken out of the layout first;
+the instructions behind a return end up in such a block when the graph is built.
+*/
+
+typedef struct
+{
+    uint32_t vreg;
+    uint32_t block;
+} ir_dce_pair_t;
+
+typedef struct
+{
+    ir_dce_pair_t *items;
+    size_t count;
+    size_t capacity;
+} ir_dce_pairs_t;
+
+typedef struct
+{
+    ir_cfg_t *cfg;
+    uint32_t vreg_count;
+
+    // per register, compared against stamp so that nothing has to be cleared between blocks
+    uint32_t *read;
+    uint32_t *written;
+    uint32_t *live;
+    uint32_t stamp;
+
+    ir_dce_pairs_t exposed; // the block reads the register before writing it
+    ir_dce_pairs_t defined; // the block writes the register
+    ir_dce_pairs_t live_in; // the register is live into the block
+    uint32_t *exposed_start;
+    uint32_t *defined_start;
+    uint32_t *live_in_start;
+    ir_dce_pair_t *sorted;
+
+    // per block, v + 1 while register v is being followed
+    uint32_t *block_live;
+    uint32_t *block_writes;
+    uint32_t *worklist;
+} ir_dce_state_t;
+
+bool ir_eliminate_dead_code(ir_cfg_t *cfg, bool *changed);
+
+static bool ir_dce_pairs_push(ir_dce_pairs_t *pairs, uint32_t vreg, uint32_t block)
+{
+    if (pairs->count == pairs->capacity)
+    {
+        size_t capacity = pairs->capacity ? pairs->capacity * 2 : 64;
+        ir_dce_pair_t *items = (ir_dce_pair_t *)allocate(capacity * sizeof(ir_dce_pair_t));
+        if (!items)
+        {
+            return false;
+        }
+
+        if (pairs->items)
+        {
+            memcpy(items, pairs->items, pairs->count * sizeof(ir_dce_pair_t));
+            deallocate(pairs->items);
+        }
+        pairs->items = items;
+        pairs->capacity = capacity;
+    }
+
+    pairs->items[pairs->count++] = (ir_dce_pair_t){.vreg = vreg, .block = block};
+    return true;
+}
+
+/*
+Counting sort of pairs by register (by_block false) or by block, in place. Afterwards the pairs
+of key k are items[start[k]] up to items[start[k + 1]].
+*/
+static bool ir_dce_group(ir_dce_state_t *state, ir_dce_pairs_t *pairs, uint32_t *start, uint32_t key_count, bool by_block)
+{
+    if (pairs->count > UINT32_MAX)
+    {
+        return false;
+    }
+
+    memset(start, 0, (key_count + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < pairs->count; i++)
+    {
+        start[(by_block ? pairs->items[i].block : pairs->items[i].vreg) + 1]++;
+    }
+    for (uint32_t k = 0; k < key_count; k++)
+    {
+        start[k + 1] += start[k];
+    }
+
+    for (size_t i = 0; i < pairs->count; i++)
+    {
+        uint32_t key = by_block ? pairs->items[i].block : pairs->items[i].vreg;
+        state->sorted[start[key]++] = pairs->items[i];
+    }
+    for (uint32_t k = key_count; k > 0; k--)
+    {
+        start[k] = start[k - 1];
+    }
+    start[0] = 0;
+    if (pairs->count)
+    {
+        memcpy(pairs->items, state->sorted, pairs->count * sizeof(ir_dce_pair_t));
+    }
+    return true;
+}
+
+static bool ir_dce_reserve_sorted(ir_dce_state_t *state, size_t *sorted_capacity, size_t count)
+{
+    if (count <= *sorted_capacity)
+    {
+        return true;
+    }
+
+    deallocate(state->sorted);
+    state->sorted = (ir_dce_pair_t *)allocate(count * sizeof(ir_dce_pair_t));
+    *sorted_capacity = state->sorted ? count : 0;
+    return state->sorted != NULL;
+}
+
+// Records which registers each reachable block reads before writing them, and which it writes
+static bool ir_dce_scan_blocks(ir_dce_state_t *state)
+{
+    ir_cfg_t *cfg = state->cfg;
+    state->exposed.count = 0;
+    state->defined.count = 0;
+
+    for (uint32_t r = 0; r < cfg->rpo_count; r++)
+    {
+        uint32_t b = cfg->rpo[r];
+        uint32_t stamp = ++state->stamp;
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type != IR_VAL_VARIABLE)
+                {
+                    continue;
+                }
+
+                uint32_t vreg = use->value.variable.vreg;
+                if (state->written[vreg] != stamp && state->read[vreg] != stamp)
+                {
+                    state->read[vreg] = stamp;
+                    if (!ir_dce_pairs_push(&state->exposed, vreg, b))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            ir_value_t *destination = ir_instruction_definition(instruction);
+            if (destination && state->written[destination->value.variable.vreg] != stamp)
+            {
+                state->written[destination->value.variable.vreg] = stamp;
+                if (!ir_dce_pairs_push(&state->defined, destination->value.variable.vreg, b))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Fills live_in with the registers live into each block, grouped by block
+static bool ir_dce_compute_liveness(ir_dce_state_t *state, size_t *sorted_capacity)
+{
+    ir_cfg_t *cfg = state->cfg;
+    if (!ir_dce_scan_blocks(state) ||
+        !ir_dce_reserve_sorted(state, sorted_capacity, state->exposed.count > state->defined.count ? state->exposed.count : state->defined.count) ||
+        !ir_dce_group(state, &state->exposed, state->exposed_start, state->vreg_count, false) ||
+        !ir_dce_group(state, &state->defined, state->defined_start, state->vreg_count, false))
+    {
+        return false;
+    }
+
+    memset(state->block_live, 0, cfg->block_count * sizeof(uint32_t));
+    memset(state->block_writes, 0, cfg->block_count * sizeof(uint32_t));
+    state->live_in.count = 0;
+
+    for (uint32_t v = 0; v < state->vreg_count; v++)
+    {
+        if (state->exposed_start[v] == state->exposed_start[v + 1])
+        {
+            continue;
+        }
+
+        uint32_t mark = v + 1;
+        for (uint32_t i = state->defined_start[v]; i < state->defined_start[v + 1]; i++)
+        {
+            state->block_writes[state->defined.items[i].block] = mark;
+        }
+
+        uint32_t worklist_count = 0;
+        for (uint32_t i = state->exposed_start[v]; i < state->exposed_start[v + 1]; i++)
+        {
+            uint32_t b = state->exposed.items[i].block;
+            state->block_live[b] = mark;
+            state->worklist[worklist_count++] = b;
+        }
+
+        // a block writing v stops the walk: v is live out of it but not into it
+        while (worklist_count)
+        {
+            uint32_t b = state->worklist[--worklist_count];
+            if (!ir_dce_pairs_push(&state->live_in, v, b))
+            {
+                return false;
+            }
+
+            const ir_block_list_t *predecessors = &cfg->blocks[b].predecessors;
+            for (uint32_t p = 0; p < predecessors->count; p++)
+            {
+                uint32_t predecessor = predecessors->items[p];
+                if (state->block_live[predecessor] != mark && state->block_writes[predecessor] != mark)
+                {
+                    state->block_live[predecessor] = mark;
+                    state->worklist[worklist_count++] = predecessor;
+                }
+            }
+        }
+    }
+
+    return ir_dce_reserve_sorted(state, sorted_capacity, state->live_in.count) &&
+           ir_dce_group(state, &state->live_in, state->live_in_start, cfg->block_count, true);
+}
+
+static inline bool ir_dce_removable(const ir_instruction_t *instruction)
+{
+    switch (instruction->type)
+    {
+    case IR_INSTR_COPY:
+    case IR_INSTR_UNARY:
+    case IR_INSTR_BINARY:
+    case IR_INSTR_PHI:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Walks block backwards from its live-out set and removes the dead definitions on the way
+static bool ir_dce_sweep_block(ir_dce_state_t *state, ir_basic_block_t *block)
+{
+    uint32_t stamp = ++state->stamp;
+    for (uint32_t s = 0; s < block->successor_count; s++)
+    {
+        uint32_t successor = block->successors[s];
+        for (uint32_t i = state->live_in_start[successor]; i < state->live_in_start[successor + 1]; i++)
+        {
+            state->live[state->live_in.items[i].vreg] = stamp;
+        }
+    }
+
+    bool removed = false;
+    instr_link_t *link = instr_list_last(&block->instructions);
+    while (link)
+    {
+        instr_link_t *previous = instr_list_prev(&block->instructions, link);
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+
+        ir_value_t *destination = ir_instruction_definition(instruction);
+        if (destination)
+        {
+            uint32_t vreg = destination->value.variable.vreg;
+            if (state->live[vreg] != stamp && ir_dce_removable(instruction))
+            {
+                instr_list_remove(&block->instructions, link);
+                removed = true;
+                link = previous;
+                continue;
+            }
+            state->live[vreg] = 0;
+        }
+
+        for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+        {
+            ir_value_t *use = ir_instruction_use(instruction, u);
+            if (use->type == IR_VAL_VARIABLE)
+            {
+                state->live[use->value.variable.vreg] = stamp;
+            }
+        }
+        link = previous;
+    }
+    return removed;
+}
+
+static bool ir_dce_remove_unreachable(ir_cfg_t *cfg)
+{
+    bool removed = false;
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[b];
+        if (block->rpo_number == IR_CFG_NO_BLOCK && !instr_list_empty(&block->instructions))
+        {
+            instr_list_init(&block->instructions);
+            ir_cfg_unlink_block(cfg, b);
+            removed = true;
+        }
+    }
+    return removed;
+}
+
+static void ir_dce_free(ir_dce_state_t *state)
+{
+    deallocate(state->read);
+    deallocate(state->written);
+    deallocate(state->live);
+    deallocate(state->exposed.items);
+    deallocate(state->defined.items);
+    deallocate(state->live_in.items);
+    deallocate(state->exposed_start);
+    deallocate(state->defined_start);
+    deallocate(state->live_in_start);
+    deallocate(state->sorted);
+    deallocate(state->block_live);
+    deallocate(state->block_writes);
+    deallocate(state->worklist);
+}
+
+bool ir_eliminate_dead_code(ir_cfg_t *cfg, bool *changed)
+{
+    if (ir_dce_remove_unreachable(cfg))
+    {
+        *changed = true;
+        if (!ir_cfg_compute_edges(cfg) || !ir_cfg_compute_dominators(cfg))
+        {
+            return false;
+        }
+    }
+
+    uint32_t vreg_count = cfg->function->vreg_count;
+    size_t vreg_bytes = (vreg_count + 1) * sizeof(uint32_t);
+    size_t block_bytes = (cfg->block_count + 1) * sizeof(uint32_t);
+    ir_dce_state_t state = {
+        .cfg = cfg,
+        .vreg_count = vreg_count,
+        .read = (uint32_t *)allocate(vreg_bytes),
+        .written = (uint32_t *)allocate(vreg_bytes),
+        .live = (uint32_t *)allocate(vreg_bytes),
+        .exposed_start = (uint32_t *)allocate(vreg_bytes),
+        .defined_start = (uint32_t *)allocate(vreg_bytes),
+        .live_in_start = (uint32_t *)allocate(block_bytes),
+        .block_live = (uint32_t *)allocate(block_bytes),
+        .block_writes = (uint32_t *)allocate(block_bytes),
+        .worklist = (uint32_t *)allocate(block_bytes),
+    };
+    if (!state.read || !state.written || !state.live || !state.exposed_start || !state.defined_start ||
+        !state.live_in_start || !state.block_live || !state.block_writes || !state.worklist)
+    {
+        ir_dce_free(&state);
+        return false;
+    }
+    memset(state.read, 0, vreg_bytes);
+    memset(state.written, 0, vreg_bytes);
+    memset(state.live, 0, vreg_bytes);
+
+    size_t sorted_capacity = 0;
+    bool removed = true;
+    while (removed)
+    {
+        if (!ir_dce_compute_liveness(&state, &sorted_capacity))
+        {
+            ir_dce_free(&state);
+            return false;
+        }
+
+        removed = false;
+        for (uint32_t r = 0; r < cfg->rpo_count; r++)
+        {
+            removed |= ir_dce_sweep_block(&state, &cfg->blocks[cfg->rpo[r]]);
+        }
+        *changed |= removed;
+    }
+
+    ir_dce_free(&state);
+    return true;
+}
+
+#endif /* B3E97C52_1D46_4A8F_9B20_6F8D4C1A7E35 */
@@ -0,0 +1,134 @@
+#ifndef F1C4E8A3_7B25_4D69_8A0F_3E92D6B15C70
+#define F1C4E8A3_7B25_4D69_8A0F_3E92D6B15C70
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "cfg.h"
+
+/*
+Def-use chains for the virtual registers of a function in CFG form. The uses of register v are
+uses[use_start[v]] up to uses[use_start[v + 1]], an instruction reading v twice is listed
+twice. In SSA form definitions[v] is the only instruction writing v. The index is a snapshot:
+a pass that adds or removes instructions has to build it again before relying on it.
+*/
+
+typedef struct
+{
+    ir_instruction_t *instruction; // NULL for a register that is never defined
+    uint32_t block;
+} ir_use_t;
+
+typedef struct
+{
+    uint32_t vreg_count;
+    uint32_t *use_start;
+    ir_use_t *uses;
+    ir_use_t *definitions; // the last definition seen when a register has several
+} ir_def_use_t;
+
+bool ir_def_use_build(ir_cfg_t *cfg, ir_def_use_t *def_use);
+void ir_def_use_free(ir_def_use_t *def_use);
+
+static inline uint32_t ir_def_use_count(const ir_def_use_t *def_use, uint32_t vreg)
+{
+    return def_use->use_start[vreg + 1] - def_use->use_start[vreg];
+}
+
+bool ir_def_use_build(ir_cfg_t *cfg, ir_def_use_t *def_use)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    memset(def_use, 0, sizeof(ir_def_use_t));
+    def_use->vreg_count = vreg_count;
+
+    def_use->use_start = (uint32_t *)allocate((vreg_count + 1) * sizeof(uint32_t));
+    def_use->definitions = (ir_use_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(ir_use_t));
+    if (!def_use->use_start || !def_use->definitions)
+    {
+        ir_def_use_free(def_use);
+        return false;
+    }
+    memset(def_use->use_start, 0, (vreg_count + 1) * sizeof(uint32_t));
+    memset(def_use->definitions, 0, (vreg_count ? vreg_count : 1) * sizeof(ir_use_t));
+
+    // count per register, turn the counts into offsets, then fill the slots from the back
+    uint32_t total = 0;
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            uint32_t use_count = ir_instruction_use_count(instruction);
+            for (uint32_t u = 0; u < use_count; u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type == IR_VAL_VARIABLE)
+                {
+                    def_use->use_start[use->value.variable.vreg + 1]++;
+                    total++;
+                }
+            }
+
+            ir_value_t *destination = ir_instruction_definition(instruction);
+            if (destination)
+            {
+                def_use->definitions[destination->value.variable.vreg] = (ir_use_t){.instruction = instruction, .block = b};
+            }
+        }
+    }
+
+    for (uint32_t v = 0; v < vreg_count; v++)
+    {
+        def_use->use_start[v + 1] += def_use->use_start[v];
+    }
+
+    def_use->uses = (ir_use_t *)allocate((total ? total : 1) * sizeof(ir_use_t));
+    if (!def_use->uses)
+    {
+        ir_def_use_free(def_use);
+        return false;
+    }
+
+    for (uint32_t b = cfg->block_count; b-- > 0;)
+    {
+        for (instr_link_t *link = instr_list_last(&cfg->blocks[b].instructions); link;
+             link = instr_list_prev(&cfg->blocks[b].instructions, link))
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            for (uint32_t u = ir_instruction_use_count(instruction); u-- > 0;)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type == IR_VAL_VARIABLE)
+                {
+                    uint32_t slot = --def_use->use_start[use->value.variable.vreg + 1];
+                    def_use->uses[slot] = (ir_use_t){.instruction = instruction, .block = b};
+                }
+            }
+        }
+    }
+
+    // the fill left the start of register v in use_start[v + 1], shift them back down
+    for (uint32_t v = 0; v < vreg_count; v++)
+    {
+        def_use->use_start[v] = def_use->use_start[v + 1];
+    }
+    def_use->use_start[vreg_count] = total;
+    return true;
+}
+
+void ir_def_use_free(ir_def_use_t *def_use)
+{
+    if (!def_use)
+    {
+        return;
+    }
+
+    deallocate(def_use->use_start);
+    deallocate(def_use->uses);
+    deallocate(def_use->definitions);
+    memset(def_use, 0, sizeof(ir_def_use_t));
+}
+
+#endif /* F1C4E8A3_7B25_4D69_8A0F_3E92D6B15C70 */
@@ -0,0 +1,283 @@
+#ifndef A47D2E95_3C18_4B6F_8E01_D59B7A0C3E24
+#define A47D2E95_3C18_4B6F_8E01_D59B7A0C3E24
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "../ir_gen/ir_generation.h"
+#include "cfg.h"
+
+/*
+Dominator based global value numbering for a function in SSA form. The dominator tree is
+walked depth first with a scoped table of the unary and binary expressions computed so far;
+an expression that is already in the table is available, because the block computing it
+dominates the current one, and the instruction becomes a copy of the earlier result.
+
+Operands are compared by value number: a register copied from another one shares its number,
+so redundancy is found through copies too. Commutative operators order their operands, and
+a > b is looked up as b < a, so x * y and y * x or a > b and b < a meet in the same entry.
+
+The table uses linear probing. Scopes close in the reverse order they opened, so an entry is
+always the last one on its probe sequence when it is taken out and clearing its slot is safe.
+*/
+
+typedef struct
+{
+    bool constant;
+    uint32_t value; // value number of a register, or the bits of a constant
+} ir_gvn_operand_t;
+
+typedef struct
+{
+    bool occupied;
+    bool binary;
+    uint32_t op;
+    ir_gvn_operand_t left;
+    ir_gvn_operand_t right;
+    uint32_t hash;
+    const ir_value_t *result;
+} ir_gvn_entry_t;
+
+typedef struct
+{
+    uint32_t block;
+    uint32_t next_child;
+    size_t log_mark;
+} ir_gvn_frame_t;
+
+typedef struct
+{
+    ir_cfg_t *cfg;
+    uint32_t *numbers; // value number of every register
+
+    ir_gvn_entry_t *entries;
+    size_t capacity;
+
+    size_t *log; // slots filled by the open scopes, innermost last
+    size_t log_count;
+} ir_gvn_state_t;
+
+bool ir_global_value_numbering(ir_cfg_t *cfg, bool *changed);
+
+static ir_gvn_operand_t ir_gvn_operand(const ir_gvn_state_t *state, const ir_value_t *value)
+{
+    if (value->type == IR_VAL_CONSTANT_INT)
+    {
+        return (ir_gvn_operand_t){.constant = true, .value = (uint32_t)value->value.constant_int};
+    }
+    return (ir_gvn_operand_t){.constant = false, .value = state->numbers[value->value.variable.vreg]};
+}
+
+static bool ir_gvn_operand_less(ir_gvn_operand_t first, ir_gvn_operand_t second)
+{
+    if (first.constant != second.constant)
+    {
+        return second.constant;
+    }
+    return first.value < second.value;
+}
+
+static bool ir_gvn_is_commutative(ir_binary_operator_type_t op)
+{
+    switch (op)
+    {
+    case IR_BINARY_MULTIPLY:
+    case IR_BINARY_ADD:
+    case IR_BINARY_EQUAL:
+    case IR_BINARY_NOT_EQUAL:
+    case IR_BINARY_BITWISE_AND:
+    case IR_BINARY_BITWISE_XOR:
+    case IR_BINARY_BITWISE_OR:
+    case IR_BINARY_LOGICAL_AND:
+    case IR_BINARY_LOGICAL_OR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Builds the lookup key of a unary or binary instruction, in canonical operand order
+static ir_gvn_entry_t ir_gvn_key(const ir_gvn_state_t *state, const ir_instruction_t *instruction)
+{
+    ir_gvn_entry_t key = {0};
+    if (instruction->type == IR_INSTR_UNARY)
+    {
+        const ir_instruction_unary_t *unary = &instruction->instruction.unary_instr;
+        key.op = unary->unary_operator->unary_op;
+        key.left = ir_gvn_operand(state, unary->source);
+    }
+    else
+    {
+        const ir_instruction_binary_t *binary = &instruction->instruction.binary_instr;
+        ir_binary_operator_type_t op = binary->binary_operator->operator;
+        ir_gvn_operand_t left = ir_gvn_operand(state, binary->left);
+        ir_gvn_operand_t right = ir_gvn_operand(state, binary->right);
+
+        bool swap = false;
+        if (op == IR_BINARY_GREATER_THAN || op == IR_BINARY_GREATER_THAN_EQUAL)
+        {
+            op = op == IR_BINARY_GREATER_THAN ? IR_BINARY_LESS_THAN : IR_BINARY_LESS_THAN_EQUAL;
+            swap = true;
+        }
+        else if (ir_gvn_is_commutative(op))
+        {
+            swap = ir_gvn_operand_less(right, left);
+        }
+
+        key.binary = true;
+        key.op = op;
+        key.left = swap ? right : left;
+        key.right = swap ? left : right;
+    }
+
+    uint32_t hash = 2166136261u;
+    uint32_t words[6] = {key.binary, key.op, key.left.constant, key.left.value, key.right.constant, key.right.value};
+    for (size_t i = 0; i < 6; i++)
+    {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    key.hash = hash;
+    return key;
+}
+
+static bool ir_gvn_same(const ir_gvn_entry_t *entry, const ir_gvn_entry_t *key)
+{
+    return entry->hash == key->hash && entry->binary == key->binary && entry->op == key->op &&
+           entry->left.constant == key->left.constant && entry->left.value == key->left.value &&
+           entry->right.constant == key->right.constant && entry->right.value == key->right.value;
+}
+
+// Numbers the instructions of one block; the table holds everything its dominators computed
+static bool ir_gvn_block(ir_gvn_state_t *state, uint32_t b, bool *changed)
+{
+    ir_basic_block_t *block = &state->cfg->blocks[b];
+    size_t mask = state->capacity - 1;
+
+    INSTR_LIST_FOR_EACH(link, &block->instructions)
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        if (instruction->type == IR_INSTR_COPY)
+        {
+            ir_instruction_copy_t *copy = &instruction->instruction.copy_instr;
+            if (copy->source->type == IR_VAL_VARIABLE)
+            {
+                state->numbers[copy->destination->value.variable.vreg] = state->numbers[copy->source->value.variable.vreg];
+            }
+            continue;
+        }
+        if (instruction->type != IR_INSTR_UNARY && instruction->type != IR_INSTR_BINARY)
+        {
+            continue;
+        }
+
+        // unary and binary instructions keep their destination in the same place
+        ir_value_t *destination = instruction->type == IR_INSTR_UNARY ? instruction->instruction.unary_instr.destination
+                                                                      : instruction->instruction.binary_instr.destination;
+        ir_gvn_entry_t key = ir_gvn_key(state, instruction);
+
+        size_t slot = key.hash & mask;
+        while (state->entries[slot].occupied && !ir_gvn_same(&state->entries[slot], &key))
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        ir_gvn_entry_t *entry = &state->entries[slot];
+        if (!entry->occupied)
+        {
+            key.occupied = true;
+            key.result = destination;
+            *entry = key;
+            state->log[state->log_count++] = slot;
+            continue;
+        }
+
+        ir_value_t *source = ir_new_use(entry->result);
+        if (!source)
+        {
+            return false;
+        }
+        source->base.parent = &instruction->base;
+
+        instruction->type = IR_INSTR_COPY;
+        instruction->instruction.copy_instr.source = source;
+        instruction->instruction.copy_instr.destination = destination;
+        state->numbers[destination->value.variable.vreg] = state->numbers[entry->result->value.variable.vreg];
+        *changed = true;
+    }
+
+    return true;
+}
+
+bool ir_global_value_numbering(ir_cfg_t *cfg, bool *changed)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    size_t expression_count = 0;
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            ir_instruction_type_t type = INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type;
+            expression_count += type == IR_INSTR_UNARY || type == IR_INSTR_BINARY;
+        }
+    }
+
+    // at most half full, so probe sequences stay short
+    size_t capacity = 16;
+    while (capacity < 2 * expression_count)
+    {
+        capacity *= 2;
+    }
+
+    ir_gvn_state_t state = {
+        .cfg = cfg,
+        .numbers = (uint32_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(uint32_t)),
+        .entries = (ir_gvn_entry_t *)allocate(capacity * sizeof(ir_gvn_entry_t)),
+        .capacity = capacity,
+        .log = (size_t *)allocate((expression_count ? expression_count : 1) * sizeof(size_t)),
+        .log_count = 0,
+    };
+    ir_gvn_frame_t *stack = (ir_gvn_frame_t *)allocate(cfg->block_count * sizeof(ir_gvn_frame_t));
+    bool ok = state.numbers && state.entries && state.log && stack;
+
+    if (ok)
+    {
+        for (uint32_t vreg = 0; vreg < vreg_count; vreg++)
+        {
+            state.numbers[vreg] = vreg;
+        }
+        memset(state.entries, 0, capacity * sizeof(ir_gvn_entry_t));
+
+        uint32_t depth = 0;
+        stack[depth++] = (ir_gvn_frame_t){.block = 0, .next_child = 0, .log_mark = 0};
+        ok = ir_gvn_block(&state, 0, changed);
+
+        while (ok && depth)
+        {
+            ir_gvn_frame_t *frame = &stack[depth - 1];
+            ir_basic_block_t *block = &cfg->blocks[frame->block];
+            if (frame->next_child < block->dom_children.count)
+            {
+                uint32_t child = block->dom_children.items[frame->next_child++];
+                stack[depth++] = (ir_gvn_frame_t){.block = child, .next_child = 0, .log_mark = state.log_count};
+                ok = ir_gvn_block(&state, child, changed);
+                continue;
+            }
+
+            while (state.log_count > frame->log_mark)
+            {
+                state.entries[state.log[--state.log_count]].occupied = false;
+            }
+            depth--;
+        }
+    }
+
+    deallocate(state.numbers);
+    deallocate(state.entries);
+    deallocate(state.log);
+    deallocate(stack);
+    return ok;
+}
+
+#endif /* A47D2E95_3C18_4B6F_8E01_D59B7A0C3E24 */
@@ -0,0 +1,77 @@
+#ifndef B59C2E07_8D14_4F3A_9E62_0AF7C3D15B48
+#define B59C2E07_8D14_4F3A_9E62_0AF7C3D15B48
+
+#include <stdbool.h>
+#include "../ast/IR/ir_ast.h"
+#include "cfg.h"
+#include "constant_folding.h"
+#include "sccp.h"
+#include "gvn.h"
+#include "copy_propagation.h"
+#include "dce.h"
+#include "branch_simplification.h"
+#include "ssa.h"
+
+/*
+IR optimization pipeline, run between IR generation and the first assembly pass. Every pass
+works on the control-flow graph of the function and reports whether it changed anything;
+the body is put back in linear form once the pipeline is done.
+
+The passes run in two rounds that each repeat until none of their passes changes anything.
+The sparse passes run on SSA form. The cleanup passes run once it is left again, since they
+feed each other: a branch removed by branch simplification can leave its condition dead, and
+removing dead code can expose copies to coalesce or constants to fold. SSA form is built only
+once, because leaving it puts the phi copies back and another round would never settle.
+
+Building with -DNO_OPTIMIZE hands the IR to the backend exactly as it was generated.
+*/
+
+bool optimize_ir_function(ir_function_t *ir_function);
+bool optimize_ir_program(ir_program_t *ir_program);
+
+bool optimize_ir_function(ir_function_t *ir_function)
+{
+    ir_cfg_t cfg;
+    bool ok = ir_cfg_build(ir_function, &cfg);
+
+    ok = ok && ir_ssa_construct(&cfg);
+    bool changed = true;
+    while (ok && changed)
+    {
+        changed = false;
+        ok = ok && ir_sccp(&cfg, &changed);
+        ok = ok && ir_global_value_numbering(&cfg, &changed);
+        ok = ok && ir_propagate_copies(&cfg, &changed);
+    }
+    ok = ok && ir_ssa_destruct(&cfg);
+
+    changed = true;
+    while (ok && changed)
+    {
+        changed = false;
+        ok = ok && ir_fold_constants(&cfg, &changed);
+        ok = ok && ir_coalesce_copies(&cfg, &changed);
+        ok = ok && ir_eliminate_dead_code(&cfg, &changed);
+        ok = ok && ir_simplify_branches(&cfg, &changed);
+    }
+
+    ir_cfg_linearize(&cfg);
+    ir_cfg_free(&cfg);
+    return ok;
+}
+
+bool optimize_ir_program(ir_program_t *ir_program)
+{
+    if (!ir_program || !ir_program->function)
+    {
+        return false;
+    }
+
+#ifdef NO_OPTIMIZE
+    return true;
+#else
+    return optimize_ir_function(ir_program->function);
+#endif
+}
+
+#endif /* B59C2E07_8D14_4F3A_9E62_0AF7C3D15B48 */
@@ -0,0 +1,379 @@
+#ifndef D82F5A1C_63E7_4B90_A4D1_9E0B7C25F386
+#define D82F5A1C_63E7_4B90_A4D1_9E0B7C25F386
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "cfg.h"
+#include "constant_folding.h"
+#include "def_use.h"
+
+/*
+Sparse conditional constant propagation (Wegman and Zadeck). Every virtual register starts out
+undefined and can only move down to a constant and then to overdefined. Two worklists drive
+the analysis: blocks that just became executable, and registers whose value just dropped,
+whose uses are evaluated again. A conditional jump on a constant only makes its taken edge
+executable, so code behind a branch that is never taken does not spoil the values, and a phi
+only meets the arguments that arrive over executable edges.
+
+A register stands for the meet of all its definitions in executable blocks. In SSA form that
+is one definition per register and the analysis is exact; variables that are assigned more
+than once only stay constant when every assignment agrees.
+
+Afterwards every use of a constant register is replaced by the constant, the definitions of
+those registers are deleted, and conditional jumps on constants are resolved.
+*/
+
+typedef enum
+{
+    SCCP_UNDEFINED,
+    SCCP_CONSTANT,
+    SCCP_OVERDEFINED,
+} ir_sccp_level_t;
+
+typedef struct
+{
+    ir_sccp_level_t level;
+    int constant_int;
+} ir_sccp_value_t;
+
+typedef struct
+{
+    ir_cfg_t *cfg;
+    ir_sccp_value_t *values;
+
+    ir_def_use_t def_use;
+
+    bool *block_executable;
+    bool *edge_executable; // successor i of block b at [2 * b + i]
+    uint32_t *block_worklist;
+    uint32_t block_worklist_count;
+
+    uint32_t *vreg_worklist; // a register drops at most twice
+    uint32_t vreg_worklist_count;
+} ir_sccp_state_t;
+
+bool ir_sccp(ir_cfg_t *cfg, bool *changed);
+
+static ir_sccp_value_t ir_sccp_operand(const ir_sccp_state_t *state, const ir_value_t *value)
+{
+    if (value->type == IR_VAL_CONSTANT_INT)
+    {
+        return (ir_sccp_value_t){.level = SCCP_CONSTANT, .constant_int = value->value.constant_int};
+    }
+    return state->values[value->value.variable.vreg];
+}
+
+static ir_sccp_value_t ir_sccp_meet(ir_sccp_value_t first, ir_sccp_value_t second)
+{
+    if (first.level == SCCP_UNDEFINED)
+    {
+        return second;
+    }
+    if (second.level == SCCP_UNDEFINED)
+    {
+        return first;
+    }
+    if (first.level == SCCP_CONSTANT && second.level == SCCP_CONSTANT && first.constant_int == second.constant_int)
+    {
+        return first;
+    }
+    return (ir_sccp_value_t){.level = SCCP_OVERDEFINED};
+}
+
+static void ir_sccp_lower(ir_sccp_state_t *state, uint32_t vreg, ir_sccp_value_t value)
+{
+    ir_sccp_value_t *current = &state->values[vreg];
+    ir_sccp_value_t lowered = ir_sccp_meet(*current, value);
+    if (lowered.level == current->level && (lowered.level != SCCP_CONSTANT || lowered.constant_int == current->constant_int))
+    {
+        return;
+    }
+
+    *current = lowered;
+    state->vreg_worklist[state->vreg_worklist_count++] = vreg;
+}
+
+static void ir_sccp_mark_block(ir_sccp_state_t *state, uint32_t block)
+{
+    if (block == IR_CFG_NO_BLOCK || state->block_executable[block])
+    {
+        return;
+    }
+
+    state->block_executable[block] = true;
+    state->block_worklist[state->block_worklist_count++] = block;
+}
+
+static void ir_sccp_visit(ir_sccp_state_t *state, uint32_t block_id, ir_instruction_t *instruction);
+
+// A new edge into a block that is already executable only changes what its phis see
+static void ir_sccp_mark_edge(ir_sccp_state_t *state, uint32_t from, uint32_t to)
+{
+    ir_basic_block_t *block = &state->cfg->blocks[from];
+    for (uint32_t i = 0; i < block->successor_count; i++)
+    {
+        if (block->successors[i] != to || state->edge_executable[2 * from + i])
+        {
+            continue;
+        }
+
+        state->edge_executable[2 * from + i] = true;
+        if (!state->block_executable[to])
+        {
+            ir_sccp_mark_block(state, to);
+            return;
+        }
+
+        INSTR_LIST_FOR_EACH(link, &state->cfg->blocks[to].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (instruction->type == IR_INSTR_PHI)
+            {
+                ir_sccp_visit(state, to, instruction);
+            }
+        }
+        return;
+    }
+}
+
+static bool ir_sccp_edge_executable(const ir_sccp_state_t *state, uint32_t from, uint32_t to)
+{
+    const ir_basic_block_t *block = &state->cfg->blocks[from];
+    for (uint32_t i = 0; i < block->successor_count; i++)
+    {
+        if (block->successors[i] == to)
+        {
+            return state->edge_executable[2 * from + i];
+        }
+    }
+    return false;
+}
+
+static ir_sccp_value_t ir_sccp_evaluate(const ir_sccp_state_t *state, uint32_t block_id, ir_instruction_t *instruction)
+{
+    ir_sccp_value_t overdefined = {.level = SCCP_OVERDEFINED};
+    ir_sccp_value_t result = {.level = SCCP_CONSTANT};
+
+    switch (instruction->type)
+    {
+    case IR_INSTR_PHI:
+    {
+        ir_instruction_phi_t *phi = &instruction->instruction.phi_instr;
+        ir_sccp_value_t merged = {.level = SCCP_UNDEFINED};
+        for (uint32_t i = 0; i < phi->argument_count; i++)
+        {
+            if (ir_sccp_edge_executable(state, phi->predecessors[i], block_id))
+            {
+                merged = ir_sccp_meet(merged, ir_sccp_operand(state, phi->arguments[i]));
+            }
+        }
+        return merged;
+    }
+    case IR_INSTR_COPY:
+        return ir_sccp_operand(state, instruction->instruction.copy_instr.source);
+    case IR_INSTR_UNARY:
+    {
+        ir_sccp_value_t source = ir_sccp_operand(state, instruction->instruction.unary_instr.source);
+        if (source.level != SCCP_CONSTANT)
+        {
+            return source;
+        }
+        return ir_eval_unary(instruction->instruction.unary_instr.unary_operator->unary_op, source.constant_int, &result.constant_int)
+                   ? result
+                   : overdefined;
+    }
+    case IR_INSTR_BINARY:
+    {
+        ir_instruction_binary_t *binary = &instruction->instruction.binary_instr;
+        ir_sccp_value_t left = ir_sccp_operand(state, binary->left);
+        ir_sccp_value_t right = ir_sccp_operand(state, binary->right);
+        if (left.level == SCCP_OVERDEFINED || right.level == SCCP_OVERDEFINED)
+        {
+            return overdefined;
+        }
+        if (left.level == SCCP_UNDEFINED || right.level == SCCP_UNDEFINED)
+        {
+            return (ir_sccp_value_t){.level = SCCP_UNDEFINED};
+        }
+        return ir_eval_binary(binary->binary_operator->operator, left.constant_int, right.constant_int, &result.constant_int)
+                   ? result
+                   : overdefined;
+    }
+    default:
+        return overdefined;
+    }
+}
+
+// Marks the successors of block that can be reached given what is known about its last instruction
+static void ir_sccp_visit_terminator(ir_sccp_state_t *state, ir_basic_block_t *block, ir_instruction_t *last)
+{
+    if (last && (last->type == IR_INSTR_JUMP_IF_ZERO || last->type == IR_INSTR_JUMP_IF_NOT_ZERO))
+    {
+        ir_sccp_value_t condition = ir_sccp_operand(state, last->instruction.jz_instr.condition);
+        if (condition.level == SCCP_UNDEFINED)
+        {
+            return;
+        }
+
+        if (condition.level == SCCP_CONSTANT)
+        {
+            bool taken = (condition.constant_int == 0) == (last->type == IR_INSTR_JUMP_IF_ZERO);
+            uint32_t target = taken ? ir_cfg_block_of_label(state->cfg, last->instruction.jz_instr.target->name)
+                                    : block->layout_next;
+            if (target != IR_CFG_NO_BLOCK)
+            {
+                ir_sccp_mark_edge(state, block->id, target);
+            }
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < block->successor_count; i++)
+    {
+        ir_sccp_mark_edge(state, block->id, block->successors[i]);
+    }
+}
+
+static void ir_sccp_visit(ir_sccp_state_t *state, uint32_t block_id, ir_instruction_t *instruction)
+{
+    ir_basic_block_t *block = &state->cfg->blocks[block_id];
+    if (instruction == ir_block_last(block) && ir_instruction_is_terminator(instruction))
+    {
+        ir_sccp_visit_terminator(state, block, instruction);
+        return;
+    }
+
+    ir_value_t *destination = ir_instruction_definition(instruction);
+    if (destination)
+    {
+        ir_sccp_lower(state, destination->value.variable.vreg, ir_sccp_evaluate(state, block_id, instruction));
+    }
+}
+
+static void ir_sccp_solve(ir_sccp_state_t *state)
+{
+    ir_sccp_mark_block(state, 0);
+
+    while (state->block_worklist_count || state->vreg_worklist_count)
+    {
+        while (state->vreg_worklist_count)
+        {
+            uint32_t vreg = state->vreg_worklist[--state->vreg_worklist_count];
+            const ir_def_use_t *def_use = &state->def_use;
+            for (uint32_t u = def_use->use_start[vreg]; u < def_use->use_start[vreg + 1]; u++)
+            {
+                if (state->block_executable[def_use->uses[u].block])
+                {
+                    ir_sccp_visit(state, def_use->uses[u].block, def_use->uses[u].instruction);
+                }
+            }
+        }
+
+        if (state->block_worklist_count)
+        {
+            uint32_t block_id = state->block_worklist[--state->block_worklist_count];
+            ir_basic_block_t *block = &state->cfg->blocks[block_id];
+            ir_instruction_t *last = ir_block_last(block);
+
+            INSTR_LIST_FOR_EACH(link, &block->instructions)
+            {
+                ir_sccp_visit(state, block_id, INSTR_LIST_ENTRY(link, ir_instruction_t, link));
+            }
+
+            // a block that ends without a jump still falls through
+            if (!last || !ir_instruction_is_terminator(last))
+            {
+                ir_sccp_visit_terminator(state, block, NULL);
+            }
+        }
+    }
+}
+
+static bool ir_sccp_rewrite(ir_sccp_state_t *state, bool *changed)
+{
+    ir_cfg_t *cfg = state->cfg;
+    bool edges_changed = false;
+
+    for (uint32_t b = 0; b < cfg->block_count; b++)
+    {
+        ir_basic_block_t *block = &cfg->blocks[b];
+        INSTR_LIST_FOR_EACH(link, &block->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+
+            ir_value_t *destination = ir_instruction_definition(instruction);
+            if (destination && state->values[destination->value.variable.vreg].level == SCCP_CONSTANT)
+            {
+                instr_list_remove(&block->instructions, link);
+                *changed = true;
+                continue;
+            }
+
+            uint32_t use_count = ir_instruction_use_count(instruction);
+            for (uint32_t u = 0; u < use_count; u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type != IR_VAL_VARIABLE)
+                {
+                    continue;
+                }
+
+                ir_sccp_value_t value = state->values[use->value.variable.vreg];
+                if (value.level == SCCP_CONSTANT)
+                {
+                    use->type = IR_VAL_CONSTANT_INT;
+                    use->value.constant_int = value.constant_int;
+                    *changed = true;
+                }
+            }
+
+            if ((instruction->type == IR_INSTR_JUMP_IF_ZERO || instruction->type == IR_INSTR_JUMP_IF_NOT_ZERO) &&
+                instruction->instruction.jz_instr.condition->type == IR_VAL_CONSTANT_INT && state->block_executable[b])
+            {
+                ir_resolve_branch(block, instruction, instruction->instruction.jz_instr.condition->value.constant_int);
+                edges_changed = true;
+            }
+        }
+    }
+
+    return !edges_changed || (ir_cfg_compute_edges(cfg) && ir_cfg_compute_dominators(cfg));
+}
+
+bool ir_sccp(ir_cfg_t *cfg, bool *changed)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    size_t vreg_slots = vreg_count ? vreg_count : 1;
+
+    ir_sccp_state_t state = {
+        .cfg = cfg,
+        .values = (ir_sccp_value_t *)allocate(vreg_slots * sizeof(ir_sccp_value_t)),
+        .block_executable = (bool *)allocate(cfg->block_count * sizeof(bool)),
+        .edge_executable = (bool *)allocate(2 * cfg->block_count * sizeof(bool)),
+        .block_worklist = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t)),
+        .vreg_worklist = (uint32_t *)allocate(2 * vreg_slots * sizeof(uint32_t)),
+    };
+
+    bool ok = state.values && state.block_executable && state.edge_executable && state.block_worklist &&
+              state.vreg_worklist && ir_def_use_build(cfg, &state.def_use);
+    if (ok)
+    {
+        memset(state.values, 0, vreg_slots * sizeof(ir_sccp_value_t));
+        memset(state.block_executable, 0, cfg->block_count * sizeof(bool));
+        memset(state.edge_executable, 0, 2 * cfg->block_count * sizeof(bool));
+        ir_sccp_solve(&state);
+        ok = ir_sccp_rewrite(&state, changed);
+    }
+
+    ir_def_use_free(&state.def_use);
+    deallocate(state.values);
+    deallocate(state.block_executable);
+    deallocate(state.edge_executable);
+    deallocate(state.block_worklist);
+    deallocate(state.vreg_worklist);
+    return ok;
+}
+
+#endif /* D82F5A1C_63E7_4B90_A4D1_9E0B7C25F386 */
@@ -0,0 +1,606 @@
+#ifndef C6A41D97_0E58_4B2F_93C7_58E1F4A2B90D
+#define C6A41D97_0E58_4B2F_93C7_58E1F4A2B90D
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../ast/IR/ir_ast.h"
+#include "../allocator/allocator.h"
+#include "../ir_gen/ir_generation.h"
+#include "cfg.h"
+
+/*
+SSA construction and destruction for a function in CFG form.
+
+Construction follows Cytron et al. Phis are placed on the iterated dominance frontier of the
+blocks assigning a register, but only for registers that are read in some block before that
+block assigns them (semi-pruned form), so temporaries that never leave their block get none.
+Renaming walks the dominator tree and gives every definition a fresh register; the source
+name is kept for dumps. A read with no definition on the way from the entry keeps the
+original register, which is never written and stays undefined.
+
+Destruction puts the copies a phi stands for at the end of each predecessor. An edge from a
+block with two successors into a block with phis is split first, otherwise the copies would
+also run on the other path. All phis of a block are parallel, so the copies for one edge are
+sequentialized: a copy goes out once no other pending copy still reads its destination, and a
+cycle is broken by saving one destination in a fresh temporary.
+*/
+
+size_t split_label_count = 0;
+
+bool ir_ssa_construct(ir_cfg_t *cfg);
+bool ir_ssa_destruct(ir_cfg_t *cfg);
+
+// First instruction after the labels that open block, NULL when there is none
+static instr_link_t *ir_ssa_after_labels(ir_basic_block_t *block)
+{
+    INSTR_LIST_FOR_EACH(link, &block->instructions)
+    {
+        if (INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type != IR_INSTR_LABEL)
+        {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+static bool ir_ssa_insert_phi(ir_cfg_t *cfg, ir_basic_block_t *block, uint32_t vreg, symbol_t name)
+{
+    ir_instruction_t *instruction = ir_new_instruction(cfg->function, IR_INSTR_PHI);
+    if (!instruction)
+    {
+        return false;
+    }
+
+    uint32_t count = block->predecessors.count;
+    ir_instruction_phi_t *phi = &instruction->instruction.phi_instr;
+    phi->destination = ir_new_variable(vreg, name);
+    phi->arguments = (ir_value_t **)allocate((count ? count : 1) * sizeof(ir_value_t *));
+    phi->predecessors = (uint32_t *)allocate((count ? count : 1) * sizeof(uint32_t));
+    phi->argument_count = count;
+    if (!phi->destination || !phi->arguments || !phi->predecessors)
+    {
+        return false;
+    }
+    phi->destination->base.parent = &instruction->base;
+
+    // every argument starts out as the original register and is renamed from its predecessor
+    for (uint32_t i = 0; i < count; i++)
+    {
+        phi->arguments[i] = ir_new_variable(vreg, name);
+        if (!phi->arguments[i])
+        {
+            return false;
+        }
+        phi->arguments[i]->base.parent = &instruction->base;
+        phi->predecessors[i] = block->predecessors.items[i];
+    }
+
+    instr_link_t *position = ir_ssa_after_labels(block);
+    if (position)
+    {
+        instr_list_insert_before(&block->instructions, position, &instruction->link);
+    }
+    else
+    {
+        instr_list_push_back(&block->instructions, &instruction->link);
+    }
+    return true;
+}
+
+static bool ir_ssa_place_phis(ir_cfg_t *cfg, uint32_t vreg_count)
+{
+    bool ok = false;
+    bool *global = (bool *)allocate((vreg_count ? vreg_count : 1) * sizeof(bool));
+    symbol_t *names = (symbol_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(symbol_t));
+    uint32_t *killed_in = (uint32_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(uint32_t));
+    ir_block_list_t *def_blocks = (ir_block_list_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(ir_block_list_t));
+    uint32_t *has_phi = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *queued = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    uint32_t *worklist = (uint32_t *)allocate(cfg->block_count * sizeof(uint32_t));
+    if (!global || !names || !killed_in || !def_blocks || !has_phi || !queued || !worklist)
+    {
+        goto cleanup;
+    }
+
+    memset(global, 0, (vreg_count ? vreg_count : 1) * sizeof(bool));
+    memset(names, 0, (vreg_count ? vreg_count : 1) * sizeof(symbol_t));
+    memset(killed_in, 0, (vreg_count ? vreg_count : 1) * sizeof(uint32_t));
+    memset(def_blocks, 0, (vreg_count ? vreg_count : 1) * sizeof(ir_block_list_t));
+    memset(has_phi, 0, cfg->block_count * sizeof(uint32_t));
+    memset(queued, 0, cfg->block_count * sizeof(uint32_t));
+
+    for (uint32_t r = 0; r < cfg->rpo_count; r++)
+    {
+        uint32_t b = cfg->rpo[r];
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type == IR_VAL_VARIABLE && killed_in[use->value.variable.vreg] != b + 1)
+                {
+                    global[use->value.variable.vreg] = true;
+                }
+            }
+
+            ir_value_t *destination = ir_instruction_definition(instruction);
+            if (!destination)
+            {
+                continue;
+            }
+
+            uint32_t vreg = destination->value.variable.vreg;
+            names[vreg] = destination->value.variable.name;
+            if (killed_in[vreg] != b + 1)
+            {
+                killed_in[vreg] = b + 1;
+                if (!ir_block_list_push(&def_blocks[vreg], b))
+                {
+                    goto cleanup;
+                }
+            }
+        }
+    }
+
+    for (uint32_t vreg = 0; vreg < vreg_count; vreg++)
+    {
+        if (!global[vreg])
+        {
+            continue;
+        }
+
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < def_blocks[vreg].count; i++)
+        {
+            queued[def_blocks[vreg].items[i]] = vreg + 1;
+            worklist[pending++] = def_blocks[vreg].items[i];
+        }
+
+        while (pending)
+        {
+            ir_basic_block_t *block = &cfg->blocks[worklist[--pending]];
+            for (uint32_t i = 0; i < block->frontier.count; i++)
+            {
+                uint32_t join = block->frontier.items[i];
+                if (has_phi[join] == vreg + 1)
+                {
+                    continue;
+                }
+
+                if (!ir_ssa_insert_phi(cfg, &cfg->blocks[join], vreg, names[vreg]))
+                {
+                    goto cleanup;
+                }
+                has_phi[join] = vreg + 1;
+
+                // the phi is a new assignment, its own frontier needs one too
+                if (queued[join] != vreg + 1)
+                {
+                    queued[join] = vreg + 1;
+                    worklist[pending++] = join;
+                }
+            }
+        }
+    }
+    ok = true;
+
+cleanup:
+    if (def_blocks)
+    {
+        for (uint32_t vreg = 0; vreg < vreg_count; vreg++)
+        {
+            ir_block_list_free(&def_blocks[vreg]);
+        }
+    }
+    deallocate(global);
+    deallocate(names);
+    deallocate(killed_in);
+    deallocate(def_blocks);
+    deallocate(has_phi);
+    deallocate(queued);
+    deallocate(worklist);
+    return ok;
+}
+
+typedef struct
+{
+    uint32_t vreg;
+    uint32_t previous;
+} ir_ssa_rename_t;
+
+typedef struct
+{
+    uint32_t block;
+    uint32_t next_child;
+    size_t log_mark;
+} ir_ssa_frame_t;
+
+// Renames the uses and definitions of block, then the phi arguments it feeds in its successors
+static bool ir_ssa_rename_block(ir_cfg_t *cfg, uint32_t b, uint32_t vreg_count, uint32_t *current,
+                                ir_ssa_rename_t **log, size_t *log_count, size_t *log_capacity)
+{
+    ir_basic_block_t *block = &cfg->blocks[b];
+    INSTR_LIST_FOR_EACH(link, &block->instructions)
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        if (instruction->type != IR_INSTR_PHI)
+        {
+            for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+            {
+                ir_value_t *use = ir_instruction_use(instruction, u);
+                if (use->type == IR_VAL_VARIABLE && use->value.variable.vreg < vreg_count)
+                {
+                    use->value.variable.vreg = current[use->value.variable.vreg];
+                }
+            }
+        }
+
+        ir_value_t *destination = ir_instruction_definition(instruction);
+        if (!destination || destination->value.variable.vreg >= vreg_count)
+        {
+            continue;
+        }
+
+        if (*log_count == *log_capacity)
+        {
+            size_t capacity = *log_capacity ? *log_capacity * 2 : 64;
+            ir_ssa_rename_t *grown = (ir_ssa_rename_t *)allocate(capacity * sizeof(ir_ssa_rename_t));
+            if (!grown)
+            {
+                return false;
+            }
+            if (*log)
+            {
+                memcpy(grown, *log, *log_count * sizeof(ir_ssa_rename_t));
+                deallocate(*log);
+            }
+            *log = grown;
+            *log_capacity = capacity;
+        }
+
+        uint32_t vreg = destination->value.variable.vreg;
+        (*log)[(*log_count)++] = (ir_ssa_rename_t){.vreg = vreg, .previous = current[vreg]};
+        current[vreg] = cfg->function->vreg_count++;
+        destination->value.variable.vreg = current[vreg];
+    }
+
+    for (uint32_t s = 0; s < block->successor_count; s++)
+    {
+        ir_basic_block_t *successor = &cfg->blocks[block->successors[s]];
+        INSTR_LIST_FOR_EACH(link, &successor->instructions)
+        {
+            ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+            if (instruction->type == IR_INSTR_LABEL)
+            {
+                continue;
+            }
+            if (instruction->type != IR_INSTR_PHI)
+            {
+                break;
+            }
+
+            ir_instruction_phi_t *phi = &instruction->instruction.phi_instr;
+            for (uint32_t i = 0; i < phi->argument_count; i++)
+            {
+                ir_value_t *argument = phi->arguments[i];
+                if (phi->predecessors[i] == b && argument->value.variable.vreg < vreg_count)
+                {
+                    argument->value.variable.vreg = current[argument->value.variable.vreg];
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool ir_ssa_rename(ir_cfg_t *cfg, uint32_t vreg_count)
+{
+    uint32_t *current = (uint32_t *)allocate((vreg_count ? vreg_count : 1) * sizeof(uint32_t));
+    ir_ssa_frame_t *stack = (ir_ssa_frame_t *)allocate(cfg->block_count * sizeof(ir_ssa_frame_t));
+    ir_ssa_rename_t *log = NULL;
+    size_t log_count = 0, log_capacity = 0;
+    bool ok = current && stack;
+
+    if (ok)
+    {
+        for (uint32_t vreg = 0; vreg < vreg_count; vreg++)
+        {
+            current[vreg] = vreg;
+        }
+
+        uint32_t depth = 0;
+        stack[depth++] = (ir_ssa_frame_t){.block = 0, .next_child = 0, .log_mark = 0};
+        ok = ir_ssa_rename_block(cfg, 0, vreg_count, current, &log, &log_count, &log_capacity);
+
+        while (ok && depth)
+        {
+            ir_ssa_frame_t *frame = &stack[depth - 1];
+            ir_basic_block_t *block = &cfg->blocks[frame->block];
+            if (frame->next_child < block->dom_children.count)
+            {
+                uint32_t child = block->dom_children.items[frame->next_child++];
+                stack[depth++] = (ir_ssa_frame_t){.block = child, .next_child = 0, .log_mark = log_count};
+                ok = ir_ssa_rename_block(cfg, child, vreg_count, current, &log, &log_count, &log_capacity);
+                continue;
+            }
+
+            // leaving the subtree, the names it introduced go out of scope
+            while (log_count > frame->log_mark)
+            {
+                log_count--;
+                current[log[log_count].vreg] = log[log_count].previous;
+            }
+            depth--;
+        }
+    }
+
+    deallocate(current);
+    deallocate(stack);
+    deallocate(log);
+    return ok;
+}
+
+bool ir_ssa_construct(ir_cfg_t *cfg)
+{
+    uint32_t vreg_count = cfg->function->vreg_count;
+    return ir_ssa_place_phis(cfg, vreg_count) && ir_ssa_rename(cfg, vreg_count);
+}
+
+typedef struct
+{
+    ir_value_t *destination;
+    ir_value_t *source;
+} ir_ssa_move_t;
+
+static bool ir_ssa_emit_copy(ir_cfg_t *cfg, ir_basic_block_t *block, instr_link_t *position,
+                             const ir_value_t *source, const ir_value_t *destination)
+{
+    ir_instruction_t *copy = ir_new_instruction(cfg->function, IR_INSTR_COPY);
+    ir_value_t *copy_source = ir_new_use(source);
+    ir_value_t *copy_destination = ir_new_use(destination);
+    if (!copy || !copy_source || !copy_destination)
+    {
+        return false;
+    }
+
+    copy_source->base.parent = &copy->base;
+    copy_destination->base.parent = &copy->base;
+    copy->instruction.copy_instr.source = copy_source;
+    copy->instruction.copy_instr.destination = copy_destination;
+
+    if (position)
+    {
+        instr_list_insert_before(&block->instructions, position, &copy->link);
+    }
+    else
+    {
+        instr_list_push_back(&block->instructions, &copy->link);
+    }
+    return true;
+}
+
+static bool ir_ssa_reads(const ir_ssa_move_t *moves, uint32_t count, uint32_t skip, uint32_t vreg)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i != skip && moves[i].source->type == IR_VAL_VARIABLE && moves[i].source->value.variable.vreg == vreg)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Emits the parallel copy moves[0..count) as a sequence of copies in front of position
+static bool ir_ssa_sequentialize(ir_cfg_t *cfg, ir_basic_block_t *block, instr_link_t *position,
+                                 ir_ssa_move_t *moves, uint32_t count)
+{
+    while (count)
+    {
+        bool emitted = false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (ir_ssa_reads(moves, count, i, moves[i].destination->value.variable.vreg))
+            {
+                continue;
+            }
+
+            if (!ir_ssa_emit_copy(cfg, block, position, moves[i].source, moves[i].destination))
+            {
+                return false;
+            }
+            moves[i] = moves[--count];
+            emitted = true;
+            break;
+        }
+
+        if (emitted)
+        {
+            continue;
+        }
+
+        // every destination is still read by another copy: a cycle, park one destination aside
+        uint32_t saved = moves[0].destination->value.variable.vreg;
+        ir_value_t *temp = ir_new_temp(cfg->function);
+        if (!temp || !ir_ssa_emit_copy(cfg, block, position, moves[0].destination, temp))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (moves[i].source->type == IR_VAL_VARIABLE && moves[i].source->value.variable.vreg == saved)
+            {
+                moves[i].source = temp;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool ir_ssa_new_label(ir_cfg_t *cfg, ir_basic_block_t *block, symbol_t label)
+{
+    ir_instruction_t *instruction = ir_new_instruction(cfg->function, IR_INSTR_LABEL);
+    if (!instruction)
+    {
+        return false;
+    }
+
+    instruction->instruction.label_instr.identifier = ir_new_identifier(label, &instruction->base);
+    instr_list_push_front(&block->instructions, &instruction->link);
+    return instruction->instruction.label_instr.identifier != NULL;
+}
+
+static bool ir_ssa_new_jump(ir_cfg_t *cfg, ir_basic_block_t *block, symbol_t target)
+{
+    ir_instruction_t *instruction = ir_new_instruction(cfg->function, IR_INSTR_JUMP);
+    if (!instruction)
+    {
+        return false;
+    }
+
+    instruction->instruction.jmp_instr.target = ir_new_identifier(target, &instruction->base);
+    instr_list_push_back(&block->instructions, &instruction->link);
+    return instruction->instruction.jmp_instr.target != NULL;
+}
+
+/*
+Puts a new block on the edge from predecessor to block and returns its id. On the fall-through
+edge it goes right between the two. A branch target gets a labelled block ending in a jump
+instead, placed after some block that cannot fall through so nothing else runs into it.
+*/
+static uint32_t ir_ssa_split_edge(ir_cfg_t *cfg, uint32_t predecessor, uint32_t target)
+{
+    if (cfg->blocks[predecessor].layout_next == target)
+    {
+        ir_basic_block_t *split = ir_cfg_insert_block_after(cfg, predecessor);
+        return split ? split->id : IR_CFG_NO_BLOCK;
+    }
+
+    ir_instruction_t *target_label = ir_block_first(&cfg->blocks[target]);
+    if (!target_label || target_label->type != IR_INSTR_LABEL)
+    {
+        return IR_CFG_NO_BLOCK;
+    }
+
+    uint32_t after = cfg->layout_tail;
+    for (uint32_t b = cfg->layout_tail; b != IR_CFG_NO_BLOCK; b = cfg->blocks[b].layout_prev)
+    {
+        ir_instruction_t *last = ir_block_last(&cfg->blocks[b]);
+        if (last && (last->type == IR_INSTR_RETURN || last->type == IR_INSTR_JUMP))
+        {
+            after = b;
+            break;
+        }
+    }
+
+    symbol_t label = intern_generated_name(".L_split", &split_label_count);
+    symbol_t target_name = target_label->instruction.label_instr.identifier->name;
+    ir_basic_block_t *split = ir_cfg_insert_block_after(cfg, after);
+    if (label == SYMBOL_NONE || !split || !ir_ssa_new_label(cfg, split, label) ||
+        !ir_ssa_new_jump(cfg, split, target_name))
+    {
+        return IR_CFG_NO_BLOCK;
+    }
+
+    // jz and jnz share their layout
+    ir_block_last(&cfg->blocks[predecessor])->instruction.jz_instr.target->name = label;
+    return split->id;
+}
+
+bool ir_ssa_destruct(ir_cfg_t *cfg)
+{
+    uint32_t block_count = cfg->block_count;
+    ir_ssa_move_t *moves = NULL;
+    uint32_t move_capacity = 0;
+    bool ok = true;
+
+    for (uint32_t b = 0; b < block_count && ok; b++)
+    {
+        uint32_t phi_count = 0;
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            phi_count += INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type == IR_INSTR_PHI;
+        }
+        if (!phi_count)
+        {
+            continue;
+        }
+
+        if (phi_count > move_capacity)
+        {
+            deallocate(moves);
+            move_capacity = phi_count;
+            moves = (ir_ssa_move_t *)allocate(move_capacity * sizeof(ir_ssa_move_t));
+            if (!moves)
+            {
+                return false;
+            }
+        }
+
+        for (uint32_t p = 0; p < cfg->blocks[b].predecessors.count && ok; p++)
+        {
+            uint32_t predecessor = cfg->blocks[b].predecessors.items[p];
+
+            uint32_t count = 0;
+            INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+            {
+                ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+                if (instruction->type != IR_INSTR_PHI)
+                {
+                    continue;
+                }
+
+                ir_instruction_phi_t *phi = &instruction->instruction.phi_instr;
+                for (uint32_t i = 0; i < phi->argument_count; i++)
+                {
+                    bool redundant = phi->arguments[i]->type == IR_VAL_VARIABLE &&
+                                     phi->arguments[i]->value.variable.vreg == phi->destination->value.variable.vreg;
+                    if (phi->predecessors[i] == predecessor && !redundant)
+                    {
+                        moves[count++] = (ir_ssa_move_t){.destination = phi->destination, .source = phi->arguments[i]};
+                        break;
+                    }
+                }
+            }
+            if (!count)
+            {
+                continue;
+            }
+
+            uint32_t copy_block = predecessor;
+            if (cfg->blocks[predecessor].successor_count > 1)
+            {
+                copy_block = ir_ssa_split_edge(cfg, predecessor, b);
+                if (copy_block == IR_CFG_NO_BLOCK)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+
+            // copies go in front of the jump that leaves the block, if there is one
+            ir_basic_block_t *block = &cfg->blocks[copy_block];
+            ir_instruction_t *last = ir_block_last(block);
+            instr_link_t *position = last && ir_instruction_is_terminator(last) ? &last->link : NULL;
+            ok = ir_ssa_sequentialize(cfg, block, position, moves, count);
+        }
+
+        INSTR_LIST_FOR_EACH(link, &cfg->blocks[b].instructions)
+        {
+            if (INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type == IR_INSTR_PHI)
+            {
+                instr_list_remove(&cfg->blocks[b].instructions, link);
+            }
+        }
+    }
+
+    deallocate(moves);
+    return ok && ir_cfg_compute_edges(cfg) && ir_cfg_compute_dominators(cfg);
+}
+
+#endif /* C6A41D97_0E58_4B2F_93C7_58E1F4A2B90D */
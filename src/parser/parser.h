@@ -8,11 +8,23 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#define PARSER_LOOKAHEAD 8 // ring buffer size in streaming mode, should always be a power of two
+
+/*
+The parser either walks a token stream that was lexed up front, or, in streaming mode,
+pulls tokens from the lexer into a small ring buffer as it goes. A token pointer returned
+by peek_token is only guaranteed to stay valid until the next advance_token.
+*/
+
 typedef struct parser_
 {
-    token_t *tokens;
+    token_stream_t *tokens;
     size_t current_index;
-    size_t token_count;
+
+    lexer_t *lexer; // streaming mode when not NULL
+    token_t lookahead[PARSER_LOOKAHEAD];
+    size_t lookahead_head;
+    size_t lookahead_count;
 } parser_t;
 
 typedef enum
@@ -49,7 +61,8 @@ typedef enum
     MIN_PRECEDENCE = PRECEDENCE_ASSIGN,
 } operator_precedence_t;
 
-parser_t *init_parser(token_t *tokens, size_t token_count);
+parser_t *init_parser(token_stream_t *tokens);
+parser_t *init_streaming_parser(lexer_t *lexer);
 program_t *parse_program(parser_t *parser);
 function_def_t *parse_function(parser_t *parser);
 statement_t *parse_statement(parser_t *parser);
@@ -128,13 +141,32 @@ static void error(const char *message, size_t line, size_t column)
     fprintf(stderr, "Line %zu, Column: %zu -> Error: %s\n", line, column, message);
 }
 
+static bool refill_lookahead(parser_t *parser)
+{
+    while (parser->lookahead_count < PARSER_LOOKAHEAD)
+    {
+        size_t slot = (parser->lookahead_head + parser->lookahead_count) & (PARSER_LOOKAHEAD - 1);
+        if (!lex_next_token(parser->lexer, &parser->lookahead[slot]))
+        {
+            break;
+        }
+        parser->lookahead_count++;
+    }
+    return parser->lookahead_count > 0;
+}
+
 static inline token_t *peek_token(parser_t *parser)
 {
-    if (parser->current_index >= parser->token_count)
+    if (!parser->lexer)
+    {
+        return token_stream_at(parser->tokens, parser->current_index);
+    }
+
+    if (!parser->lookahead_count && !refill_lookahead(parser))
     {
         return NULL;
     }
-    return &(parser->tokens[parser->current_index]);
+    return &parser->lookahead[parser->lookahead_head];
 }
 
 static inline token_t *advance_token(parser_t *parser)
@@ -143,6 +175,11 @@ static inline token_t *advance_token(parser_t *parser)
     if (current)
     {
         parser->current_index++;
+        if (parser->lexer)
+        {
+            parser->lookahead_head = (parser->lookahead_head + 1) & (PARSER_LOOKAHEAD - 1);
+            parser->lookahead_count--;
+        }
     }
     return current;
 }
@@ -168,7 +205,7 @@ static bool expect_token(parser_t *parser, token_type_t expected, const char *er
     return true;
 }
 
-parser_t *init_parser(token_t *tokens, size_t token_count)
+parser_t *init_parser(token_stream_t *tokens)
 {
     if (!tokens)
     {
@@ -183,7 +220,31 @@ parser_t *init_parser(token_t *tokens, size_t token_count)
 
     parser->tokens = tokens;
     parser->current_index = 0;
-    parser->token_count = token_count;
+    parser->lexer = NULL;
+    parser->lookahead_head = 0;
+    parser->lookahead_count = 0;
+
+    return parser;
+}
+
+parser_t *init_streaming_parser(lexer_t *lexer)
+{
+    if (!lexer)
+    {
+        return NULL;
+    }
+
+    parser_t *parser = (parser_t *)allocate(sizeof(parser_t));
+    if (!parser)
+    {
+        return NULL;
+    }
+
+    parser->tokens = NULL;
+    parser->current_index = 0;
+    parser->lexer = lexer;
+    parser->lookahead_head = 0;
+    parser->lookahead_count = 0;
 
     return parser;
 }
@@ -210,7 +271,7 @@ identifier_t *parse_identifier(parser_t *parser)
     identifier->base.location.line = token->line;
     identifier->base.location.column = token->column;
     identifier->base.parent = NULL;
-    identifier->name = token->value;
+    identifier->name = token->value.symbol;
 
     advance_token(parser);
     return identifier;
@@ -234,7 +295,7 @@ binary_operator_t *parse_binary_operator(parser_t *parser)
     token_t *curr_tok = peek_token(parser);
     if (!curr_tok)
     {
-        free(binary_operator);
+        deallocate(binary_operator);
         return NULL;
     }
 
@@ -300,7 +361,7 @@ binary_operator_t *parse_binary_operator(parser_t *parser)
         break;
 
     default:
-        free(binary_operator);
+        deallocate(binary_operator);
         return NULL;
     }
 
@@ -319,11 +380,12 @@ expression_t *parse_expression(parser_t *parser, operator_precedence_t min_prece
         return NULL;
     }
 
-    token_t *curr_tok = peek_token(parser);
-    if (!curr_tok)
+    token_t *start_tok = peek_token(parser);
+    if (!start_tok)
     {
         return NULL;
     }
+    token_t curr_tok = *start_tok;
 
     expression_t *left = parse_factor(parser);
     if (!left)
@@ -331,8 +393,8 @@ expression_t *parse_expression(parser_t *parser, operator_precedence_t min_prece
         return NULL;
     }
 
-    left->base.location.column = curr_tok->column;
-    left->base.location.line = curr_tok->line;
+    left->base.location.column = curr_tok.column;
+    left->base.location.line = curr_tok.line;
 
     while (true)
     {
@@ -405,11 +467,12 @@ static bool is_valid_operator(token_type_t type)
 static expression_t *parse_assignment_expression(parser_t *parser, expression_t *left)
 {
     advance_token(parser);
-    token_t *tok = peek_token(parser);
-    if (!tok)
+    token_t *rvalue_tok = peek_token(parser);
+    if (!rvalue_tok)
     {
         return NULL;
     }
+    token_t tok = *rvalue_tok;
 
     expression_t *expr_assign = (expression_t *)allocate(sizeof(expression_t));
     if (!expr_assign)
@@ -417,8 +480,8 @@ static expression_t *parse_assignment_expression(parser_t *parser, expression_t
         return NULL;
     }
 
-    expr_assign->base.location.column = tok->column;
-    expr_assign->base.location.line = tok->line;
+    expr_assign->base.location.column = tok.column;
+    expr_assign->base.location.line = tok.line;
     expr_assign->expr_type = EXPR_ASSIGN;
     expr_assign->base.type = NODE_EXPRESSION;
 
@@ -429,8 +492,8 @@ static expression_t *parse_assignment_expression(parser_t *parser, expression_t
         return NULL;
     }
 
-    rvalue->base.location.column = tok->column;
-    rvalue->base.location.line = tok->line;
+    rvalue->base.location.column = tok.column;
+    rvalue->base.location.line = tok.line;
     rvalue->base.parent = &(expr_assign->base);
     rvalue->base.type = NODE_EXPRESSION;
 
@@ -451,10 +514,10 @@ static expression_t *parse_binary_expression(parser_t *parser, expression_t *lef
         return NULL;
     }
 
-    token_t *next_token = peek_token(parser);
+    token_t next_token = *peek_token(parser);
     binary_expr->base.type = NODE_EXPRESSION;
-    binary_expr->base.location.line = next_token->line;
-    binary_expr->base.location.column = next_token->column;
+    binary_expr->base.location.line = next_token.line;
+    binary_expr->base.location.column = next_token.column;
     binary_expr->base.parent = NULL;
     binary_expr->expr_type = EXPR_BINARY;
 
@@ -464,8 +527,8 @@ static expression_t *parse_binary_expression(parser_t *parser, expression_t *lef
         deallocate(binary_expr);
         return NULL;
     }
-    bin_op->base.location.column = next_token->column;
-    bin_op->base.location.line = next_token->line;
+    bin_op->base.location.column = next_token.column;
+    bin_op->base.location.line = next_token.line;
 
     expression_t *right = parse_expression(parser, current_precedence + 1);
     if (!right)
@@ -494,11 +557,14 @@ expression_t *parse_factor(parser_t *parser)
     {
         return NULL;
     }
-    token_t *token = peek_token(parser);
-    if (!token)
+    token_t *current = peek_token(parser);
+    if (!current)
     {
         return NULL;
     }
+    // nested factors advance well past this token, so keep a copy of it
+    token_t factor_token = *current;
+    token_t *token = &factor_token;
 
     expression_t *expression = (expression_t *)allocate(sizeof(expression_t));
     if (!expression)
@@ -527,7 +593,7 @@ expression_t *parse_factor(parser_t *parser)
         name->base.location.line = token->line;
         name->base.type = NODE_IDENTIFIER;
 
-        name->name = strdup(token->value);
+        name->name = token->value.symbol;
 
         expression->value.var.name = name;
         advance_token(parser);
@@ -541,7 +607,7 @@ expression_t *parse_factor(parser_t *parser)
         expression->base.location.column = token->column;
         expression->base.parent = NULL;
         expression->expr_type = EXPR_CONSTANT_INT;
-        expression->value.constant_int = atoi(token->value);
+        expression->value.constant_int = token->value.constant;
 
         advance_token(parser);
         break;
@@ -564,12 +630,12 @@ expression_t *parse_factor(parser_t *parser)
             token_t *current_token = peek_token(parser);
             if (!expecting_closing_paren)
             {
-                fprintf(stderr, "Line %zu, Column: %zu -> Error: Expected an expression\n",
+                fprintf(stderr, "Line %u, Column: %u -> Error: Expected an expression\n",
                         current_token->line, current_token->column);
             }
             else
             {
-                fprintf(stderr, "Line %zu, Column: %zu -> Error: Expected closing parenthesis\n",
+                fprintf(stderr, "Line %u, Column: %u -> Error: Expected closing parenthesis\n",
                         current_token->line, current_token->column);
             }
             return NULL;
@@ -603,7 +669,7 @@ expression_t *parse_factor(parser_t *parser)
         if (!nested_expression)
         {
             token_t *current_token = peek_token(parser);
-            fprintf(stderr, "Line %zu, Column: %zu -> Error: Expected an expression\n",
+            fprintf(stderr, "Line %u, Column: %u -> Error: Expected an expression\n",
                     current_token->line, current_token->column);
             return NULL;
         }
@@ -639,7 +705,7 @@ expression_t *parse_factor(parser_t *parser)
     }
 
     default:
-        fprintf(stderr, "Line %zu, Column: %zu -> Unexpected token type\n",
+        fprintf(stderr, "Line %u, Column: %u -> Unexpected token type\n",
                 token->line, token->column);
         return NULL;
     }
@@ -769,8 +835,14 @@ static void free_block_item(block_item_t *item)
 
 function_def_t *parse_function(parser_t *parser)
 {
-    token_t *int_token = peek_token(parser);
-    if (!int_token || !expect_token(parser, TOKEN_KEYWORD_INT, "Expected 'int' for function definition"))
+    token_t *first_token = peek_token(parser);
+    if (!first_token)
+    {
+        return NULL;
+    }
+    token_t int_token = *first_token;
+
+    if (!expect_token(parser, TOKEN_KEYWORD_INT, "Expected 'int' for function definition"))
     {
         return NULL;
     }
@@ -782,8 +854,8 @@ function_def_t *parse_function(parser_t *parser)
     }
 
     function->base.type = NODE_FUNCTION_DEF;
-    function->base.location.line = int_token->line;
-    function->base.location.column = int_token->column;
+    function->base.location.line = int_token.line;
+    function->base.location.column = int_token.column;
     function->base.parent = NULL;
     function->body = NULL;
     function->block_count = 0;
@@ -868,8 +940,10 @@ function_def_t *parse_function(parser_t *parser)
             return NULL;
         }
 
-        if (strcmp(curr_tok->value, "int") == 0)
+        if (curr_tok->type == TOKEN_KEYWORD_INT)
         {
+            size_t dec_line = curr_tok->line;
+            size_t dec_column = curr_tok->column;
             advance_token(parser);
 
             declaration_t *dec = (declaration_t *)allocate(sizeof(declaration_t));
@@ -884,14 +958,18 @@ function_def_t *parse_function(parser_t *parser)
 
             dec->base.parent = &(function->base);
             dec->base.type = NODE_DECLARATION;
-            dec->base.location.column = curr_tok->column;
-            dec->base.location.line = curr_tok->line;
+            dec->base.location.column = dec_column;
+            dec->base.location.line = dec_line;
             dec->has_init_expr = false;
             dec->init_expr = NULL;
 
             curr_tok = peek_token(parser);
-            if (!curr_tok)
+            if (!curr_tok || curr_tok->type != TOKEN_IDENTIFIER)
             {
+                if (curr_tok)
+                {
+                    error("Expected identifier in declaration", curr_tok->line, curr_tok->column);
+                }
                 deallocate(dec);
                 deallocate(item);
                 function->body = stmt_arr;
@@ -915,18 +993,7 @@ function_def_t *parse_function(parser_t *parser)
             var_name->base.type = NODE_IDENTIFIER;
             var_name->base.location.column = curr_tok->column;
             var_name->base.location.line = curr_tok->line;
-            var_name->name = strdup(curr_tok->value);
-
-            if (!var_name->name)
-            {
-                deallocate(var_name);
-                deallocate(dec);
-                deallocate(item);
-                function->body = stmt_arr;
-                function->block_count = counter;
-                free_function_def(function);
-                return NULL;
-            }
+            var_name->name = curr_tok->value.symbol;
 
             dec->name = var_name;
             advance_token(parser);
@@ -942,7 +1009,7 @@ function_def_t *parse_function(parser_t *parser)
                 return NULL;
             }
 
-            if (!strcmp(curr_tok->value, "="))
+            if (curr_tok->type == TOKEN_OPERATOR_ASSIGN)
             {
                 advance_token(parser);
                 dec->has_init_expr = true;
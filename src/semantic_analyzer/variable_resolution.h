@@ -9,25 +9,20 @@ bool var_res_pass(program_t *program);
 bool resolve_statement(statement_t *statement, var_table_t *var_table);
 bool resolve_declaration(declaration_t *declaration, var_table_t *var_table);
 bool resolve_expression(expression_t *expression, var_table_t *var_table);
-char *make_unique_name(const char *name);
+symbol_t make_unique_name(symbol_t name);
 
 size_t unique_name_count = 0;
 
-char *make_unique_name(const char *name)
+symbol_t make_unique_name(symbol_t name)
 {
-    char *new_name = (char *)allocate(sizeof(char) * 256);
-    if (!new_name)
+    char new_name[256];
+    int length = snprintf(new_name, sizeof(new_name), "%s.%zu", symbol_name(name), unique_name_count++);
+    if (length < 0 || (size_t)length >= sizeof(new_name))
     {
-        return NULL;
+        return SYMBOL_NONE;
     }
 
-    if (snprintf(new_name, 256, "%s.%zu", name, unique_name_count++) < 0)
-    {
-        deallocate(new_name);
-        return NULL;
-    }
-
-    return new_name;
+    return intern_string(new_name, (size_t)length);
 }
 
 bool resolve_declaration(declaration_t *declaration, var_table_t *var_table)
@@ -43,8 +38,8 @@ bool resolve_declaration(declaration_t *declaration, var_table_t *var_table)
         return false;
     }
 
-    char *var_name = var->name;
-    if (!var_name)
+    symbol_t var_name = var->name;
+    if (var_name == SYMBOL_NONE)
     {
         return false;
     }
@@ -52,14 +47,12 @@ bool resolve_declaration(declaration_t *declaration, var_table_t *var_table)
     var_node_t *searched_node = var_table_search(var_table, var_name);
     if (!searched_node)
     {
-        char *new_unique_name = make_unique_name(var_name);
-        if (!new_unique_name || !var_table_insert(var_table, var_name, new_unique_name))
+        symbol_t new_unique_name = make_unique_name(var_name);
+        if (new_unique_name == SYMBOL_NONE || !var_table_insert(var_table, var_name, new_unique_name))
         {
-            deallocate(new_unique_name);
             return false;
         }
 
-        deallocate(var_name);
         declaration->name->name = new_unique_name;
 
         if (declaration->has_init_expr)
@@ -74,7 +67,7 @@ bool resolve_declaration(declaration_t *declaration, var_table_t *var_table)
     }
 
     fprintf(stderr, "Error -> Line: %zu Column: %zu -> Redeclaration of the variable %s\n",
-            var->base.location.line, var->base.location.column, var_name);
+            var->base.location.line, var->base.location.column, symbol_name(var_name));
     return false;
 }
 
@@ -103,7 +96,7 @@ bool resolve_expression(expression_t *expression, var_table_t *var_table)
 
         variable_t var = lvalue->value.var;
         identifier_t *iden = var.name;
-        if (!iden || !iden->name)
+        if (!iden || iden->name == SYMBOL_NONE)
         {
             return false;
         }
@@ -112,13 +105,11 @@ bool resolve_expression(expression_t *expression, var_table_t *var_table)
         if (!searched_node)
         {
             fprintf(stderr, "Error -> Line: %zu Column: %zu -> Undeclared Variable %s\n",
-                    expression->base.location.line, expression->base.location.column, iden->name);
+                    expression->base.location.line, expression->base.location.column, symbol_name(iden->name));
             return false;
         }
 
-        char *old_name = iden->name;
-        iden->name = strdup(searched_node->unique_name);
-        deallocate(old_name);
+        iden->name = searched_node->value.symbol;
 
         return resolve_expression(assign.rvalue, var_table);
     }
@@ -143,7 +134,7 @@ bool resolve_expression(expression_t *expression, var_table_t *var_table)
     {
         variable_t var = expression->value.var;
         identifier_t *iden = var.name;
-        if (!iden || !iden->name)
+        if (!iden || iden->name == SYMBOL_NONE)
         {
             return false;
         }
@@ -152,13 +143,11 @@ bool resolve_expression(expression_t *expression, var_table_t *var_table)
         if (!searched_node)
         {
             fprintf(stderr, "Error -> Line: %zu Column: %zu -> %s not declared in the current scope\n",
-                    iden->base.location.line, iden->base.location.column, iden->name);
+                    iden->base.location.line, iden->base.location.column, symbol_name(iden->name));
             return false;
         }
 
-        char *old_name = iden->name;
-        iden->name = strdup(searched_node->unique_name);
-        deallocate(old_name);
+        iden->name = searched_node->value.symbol;
 
         return true;
     }
@@ -0,0 +1,206 @@
+#ifndef E2B7C1D4_5A3F_4C8E_9B61_7D0F2A94C3E8
+#define E2B7C1D4_5A3F_4C8E_9B61_7D0F2A94C3E8
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/*
+The interner maps every distinct identifier spelling to a stable 32-bit symbol id.
+The characters themselves are copied once into large blocks that are never moved,
+so the pointer returned by symbol_name stays valid for the whole compilation.
+*/
+
+typedef uint32_t symbol_t;
+
+#define SYMBOL_NONE ((symbol_t)0) // id 0 is never handed out
+#define INTERNER_BLOCK_SIZE 65536
+#define INTERNER_INITIAL_SLOTS 1024 // should always be a power of two
+
+typedef struct interner_block_
+{
+    struct interner_block_ *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} interner_block_t;
+
+typedef struct
+{
+    const char *str;
+    uint32_t length;
+    uint32_t hash;
+} interner_entry_t;
+
+typedef struct
+{
+    interner_block_t *blocks;
+    interner_entry_t *entries; // indexed by symbol id
+    size_t entry_count;
+    size_t entry_capacity;
+    symbol_t *slots; // open addressing, SYMBOL_NONE marks an empty slot
+    size_t slot_count;
+} string_interner_t;
+
+string_interner_t string_interner = {0};
+
+symbol_t intern_string(const char *str, size_t length);
+symbol_t intern_cstring(const char *str);
+const char *symbol_name(symbol_t symbol);
+size_t symbol_length(symbol_t symbol);
+
+static uint32_t interner_hash(const char *str, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char *interner_store(const char *str, size_t length)
+{
+    interner_block_t *block = string_interner.blocks;
+    if (!block || block->capacity - block->used < length + 1)
+    {
+        size_t capacity = length + 1 > INTERNER_BLOCK_SIZE ? length + 1 : INTERNER_BLOCK_SIZE;
+        block = (interner_block_t *)malloc(sizeof(interner_block_t) + capacity);
+        if (!block)
+        {
+            return NULL;
+        }
+
+        block->used = 0;
+        block->capacity = capacity;
+        block->next = string_interner.blocks;
+        string_interner.blocks = block;
+    }
+
+    char *copy = block->data + block->used;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    block->used += length + 1;
+    return copy;
+}
+
+static bool interner_grow_slots(void)
+{
+    size_t new_count = string_interner.slot_count ? string_interner.slot_count * 2 : INTERNER_INITIAL_SLOTS;
+    symbol_t *new_slots = (symbol_t *)calloc(new_count, sizeof(symbol_t));
+    if (!new_slots)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < string_interner.slot_count; i++)
+    {
+        symbol_t symbol = string_interner.slots[i];
+        if (symbol == SYMBOL_NONE)
+        {
+            continue;
+        }
+
+        size_t index = string_interner.entries[symbol].hash & (new_count - 1);
+        while (new_slots[index] != SYMBOL_NONE)
+        {
+            index = (index + 1) & (new_count - 1);
+        }
+        new_slots[index] = symbol;
+    }
+
+    free(string_interner.slots);
+    string_interner.slots = new_slots;
+    string_interner.slot_count = new_count;
+    return true;
+}
+
+symbol_t intern_string(const char *str, size_t length)
+{
+    if (!str || length > UINT32_MAX)
+    {
+        return SYMBOL_NONE;
+    }
+
+    // keep the load factor at or below one half
+    if ((string_interner.entry_count + 1) * 2 > string_interner.slot_count && !interner_grow_slots())
+    {
+        return SYMBOL_NONE;
+    }
+
+    uint32_t hash = interner_hash(str, length);
+    size_t mask = string_interner.slot_count - 1;
+    size_t index = hash & mask;
+
+    while (string_interner.slots[index] != SYMBOL_NONE)
+    {
+        interner_entry_t *entry = &string_interner.entries[string_interner.slots[index]];
+        if (entry->hash == hash && entry->length == length && !memcmp(entry->str, str, length))
+        {
+            return string_interner.slots[index];
+        }
+        index = (index + 1) & mask;
+    }
+
+    if (string_interner.entry_count == 0)
+    {
+        string_interner.entry_count = 1; // reserve SYMBOL_NONE
+    }
+
+    if (string_interner.entry_count >= string_interner.entry_capacity)
+    {
+        size_t new_capacity = string_interner.entry_capacity ? string_interner.entry_capacity * 2 : INTERNER_INITIAL_SLOTS;
+        interner_entry_t *new_entries = (interner_entry_t *)realloc(string_interner.entries, new_capacity * sizeof(interner_entry_t));
+        if (!new_entries)
+        {
+            return SYMBOL_NONE;
+        }
+        string_interner.entries = new_entries;
+        string_interner.entry_capacity = new_capacity;
+    }
+
+    char *copy = interner_store(str, length);
+    if (!copy)
+    {
+        return SYMBOL_NONE;
+    }
+
+    symbol_t symbol = (symbol_t)string_interner.entry_count++;
+    string_interner.entries[symbol] = (interner_entry_t){.str = copy, .length = (uint32_t)length, .hash = hash};
+    string_interner.slots[index] = symbol;
+    return symbol;
+}
+
+symbol_t intern_cstring(const char *str)
+{
+    if (!str)
+    {
+        return SYMBOL_NONE;
+    }
+    return intern_string(str, strlen(str));
+}
+
+const char *symbol_name(symbol_t symbol)
+{
+    if (symbol == SYMBOL_NONE || symbol >= string_interner.entry_count)
+    {
+        return NULL;
+    }
+    return string_interner.entries[symbol].str;
+}
+
+size_t symbol_length(symbol_t symbol)
+{
+    if (symbol == SYMBOL_NONE || symbol >= string_interner.entry_count)
+    {
+        return 0;
+    }
+    return string_interner.entries[symbol].length;
+}
+
+#undef INTERNER_BLOCK_SIZE
+#undef INTERNER_INITIAL_SLOTS
+
+#endif /* E2B7C1D4_5A3F_4C8E_9B61_7D0F2A94C3E8 */
@@ -136,7 +136,7 @@ void visit_identifier(identifier_t *identifier)
         printf("Visiting NULL Identifier\n");
         return;
     }
-    printf("Visiting Identifier: %s\n", identifier->name);
+    printf("Visiting Identifier: %s\n", symbol_name(identifier->name));
 }
 
 void visit_binary_operator(binary_operator_t *binary_op)
@@ -212,11 +212,12 @@ void visit_asm_function(asm_function_t *asm_function)
         printf("Visiting NULL Assembly Function\n");
         return;
     }
-    printf("Visiting Assembly Function: %s\n", asm_function->name->name);
-    for (size_t i = 0; i < asm_function->instruction_count; i++)
+    printf("Visiting Assembly Function: %s\n", symbol_name(asm_function->name->name));
+    size_t i = 0;
+    INSTR_LIST_FOR_EACH(link, &asm_function->instructions)
     {
-        printf("Instruction %zu:\n", i + 1);
-        visit_asm_instruction(asm_function->instructions[i]);
+        printf("Instruction %zu:\n", ++i);
+        visit_asm_instruction(INSTR_LIST_ENTRY(link, asm_instruction_t, link));
     }
 }
 
@@ -319,7 +320,7 @@ void visit_asm_operand(asm_operand_t *operand)
         break;
 
     case OPERAND_PSEUDO:
-        printf("Pseudo Register: %s\n", operand->operand.pseudo.pseudo_name);
+        printf("Pseudo Register: %%%u\n", operand->operand.pseudo.vreg);
         break;
 
     case OPERAND_STACK:
@@ -340,7 +341,7 @@ void visit_asm_identifier(asm_identifier_t *identifier)
         return;
     }
 
-    printf("Visiting Assembly Identifier: %s\n", identifier->name);
+    printf("Visiting Assembly Identifier: %s\n", symbol_name(identifier->name));
 }
 
 /* int main(int argc, char **argv)
@@ -440,12 +441,12 @@ void visit_ir_function(ir_function_t *ir_function)
     if (!ir_function)
         return;
 
-    printf("Visiting IR Function: %s\n", ir_function->name->name);
+    printf("Visiting IR Function: %s\n", symbol_name(ir_function->name->name));
     visit_ir_identifier(ir_function->name);
 
-    for (size_t i = 0; i < ir_function->instruction_count; i++)
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
     {
-        visit_ir_instruction(ir_function->body[i]);
+        visit_ir_instruction(INSTR_LIST_ENTRY(link, ir_instruction_t, link));
     }
 }
 
@@ -533,11 +534,12 @@ void visit_ir_value(ir_value_t *ir_value)
         printf("Visiting IR Constant Int: %d\n", ir_value->value.constant_int);
         break;
     case IR_VAL_VARIABLE:
-        printf("Visiting IR Variable\n");
-        if (ir_value->value.variable.identifier)
+        printf("Visiting IR Variable: %%%u", ir_value->value.variable.vreg);
+        if (ir_value->value.variable.name != SYMBOL_NONE)
         {
-            visit_ir_identifier(ir_value->value.variable.identifier);
+            printf(" (%s)", symbol_name(ir_value->value.variable.name));
         }
+        printf("\n");
         break;
     default:
         printf("Unknown IR Value Type\n");
@@ -574,7 +576,7 @@ void visit_ir_identifier(ir_identifier_t *ir_identifier)
 {
     if (!ir_identifier)
         return;
-    printf("Visiting IR Identifier: %s\n", ir_identifier->name);
+    printf("Visiting IR Identifier: %s\n", symbol_name(ir_identifier->name));
 }
 
 int main(int argc, char **argv)
@@ -585,35 +587,40 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    size_t file_size;
-    uint8_t *source = read_source_file(argv[1], &file_size);
-    if (!source)
+    source_buffer_t source;
+    if (!read_source_file(argv[1], &source))
     {
         return EXIT_FAILURE;
     }
 
-    token_list_t token_list = {0};
-    if (!lex_source(source, &token_list))
+    token_stream_t tokens;
+    if (!token_stream_init(&tokens, source.size) || !lex_source(source.data, source.size, &tokens))
     {
         fprintf(stderr, "Lexing failed\n");
-        free(source);
+        token_stream_free(&tokens);
+        release_source_file(&source);
         return EXIT_FAILURE;
     }
 
     printf("Tokens:\n");
-    for (size_t i = 0; i < token_list.count; i++)
-    {
-        printf("Line %zu, Col %zu: %-15s '%s'\n",
-               token_list.tokens[i].line,
-               token_list.tokens[i].column,
-               token_type_to_string(token_list.tokens[i].type),
-               token_list.tokens[i].value);
-    }
-
-    free(source);
-
-    parser_t *parser = init_parser(token_list.tokens, token_list.count);
+    for (size_t i = 0; i < tokens.count; i++)
+    {
+        const token_t *token = token_stream_at(&tokens, i);
+        printf("Line %u, Col %u: %-15s '%.*s'\n",
+               token->line,
+               token->column,
+               token_type_to_string(token->type),
+               (int)token->length,
+               (const char *)source.data + token->offset);
+    }
+    token_stream_free(&tokens);
+
+    // the dump above lexed the whole file up front, the parser pulls its tokens on demand like the compiler does
+    lexer_t lexer;
+    init_lexer(&lexer, source.data, source.size);
+    parser_t *parser = init_streaming_parser(&lexer);
     program_t *ast = parse_program(parser);
+    release_source_file(&source);
 
     if (ast)
     {
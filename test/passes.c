@@ -0,0 +1,811 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../src/optimizer/optimizer.h"
+#include "../src/assembly_gen/from_IR/peephole.h"
+
+/*
+Tests for the optimizer passes and the peephole pass, run with `make check`. Every test
+builds a small function by hand, runs a single pass over it and checks the instructions that
+come out. Going through the front end would not do: every valid program folds down to a
+constant return long before these passes see the patterns below.
+*/
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+typedef bool (*ir_pass_t)(ir_cfg_t *cfg, bool *changed);
+
+static ir_function_t *new_function(uint32_t vreg_count)
+{
+    ir_function_t *ir_function = (ir_function_t *)allocate(sizeof(ir_function_t));
+    ir_function->base.type = IR_NODE_FUNCTION;
+    ir_function->base.parent = NULL;
+    ir_function->name = ir_new_identifier(intern_cstring("test"), &ir_function->base);
+    instr_list_init(&ir_function->body);
+    ir_function->vreg_count = vreg_count;
+    return ir_function;
+}
+
+static ir_value_t *reg(uint32_t vreg)
+{
+    return ir_new_variable(vreg, SYMBOL_NONE);
+}
+
+static ir_value_t *imm(int constant_int)
+{
+    return ir_new_constant(constant_int);
+}
+
+static void emit_binary(ir_function_t *ir_function, ir_binary_operator_type_t op, ir_value_t *left, ir_value_t *right,
+                        uint32_t destination)
+{
+    ir_instruction_t *instruction = ir_emit_instruction(ir_function, IR_INSTR_BINARY);
+    ir_binary_operator_t *binary_operator = (ir_binary_operator_t *)allocate(sizeof(ir_binary_operator_t));
+    binary_operator->base.type = IR_NODE_BINARY_OPERATOR;
+    binary_operator->base.parent = &instruction->base;
+    binary_operator->operator = op;
+    instruction->instruction.binary_instr = (ir_instruction_binary_t){binary_operator, left, right, reg(destination)};
+}
+
+static void emit_return(ir_function_t *ir_function, ir_value_t *value)
+{
+    ir_instruction_t *instruction = ir_emit_instruction(ir_function, IR_INSTR_RETURN);
+    instruction->instruction.return_instr.value = value;
+}
+
+static size_t instruction_count(ir_function_t *ir_function)
+{
+    size_t count = 0;
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        count++;
+    }
+    return count;
+}
+
+// Runs pass over the control-flow graph of ir_function and puts the body back in linear form
+static bool run_pass(ir_function_t *ir_function, ir_pass_t pass)
+{
+    ir_cfg_t cfg;
+    bool changed = false;
+    bool ok = ir_cfg_build(ir_function, &cfg) && pass(&cfg, &changed);
+    CHECK(ok);
+    ir_cfg_linearize(&cfg);
+    ir_cfg_free(&cfg);
+    return changed;
+}
+
+static ir_instruction_t *instruction_at(ir_function_t *ir_function, size_t index)
+{
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        if (!index--)
+        {
+            return INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        }
+    }
+    return NULL;
+}
+
+static bool is_reg(const ir_value_t *value, uint32_t vreg)
+{
+    return value && value->type == IR_VAL_VARIABLE && value->value.variable.vreg == vreg;
+}
+
+static bool is_copy(const ir_instruction_t *instruction, uint32_t destination, uint32_t source)
+{
+    return instruction && instruction->type == IR_INSTR_COPY &&
+           is_reg(instruction->instruction.copy_instr.destination, destination) &&
+           is_reg(instruction->instruction.copy_instr.source, source);
+}
+
+static size_t count_type(ir_function_t *ir_function, ir_instruction_type_t type)
+{
+    size_t count = 0;
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        count += INSTR_LIST_ENTRY(link, ir_instruction_t, link)->type == type;
+    }
+    return count;
+}
+
+/*
+A diamond:
+
+        jz %0, .L_else      block 0
+        %1 = 1              block 1
+        jmp .L_join
+    .L_else:
+        %1 = 2              block 2
+    .L_join:
+        return %1           block 3
+
+The entry immediately dominates the other three, and the join is the frontier of both arms.
+*/
+static void test_dominators_diamond(void)
+{
+    ir_function_t *ir_function = new_function(2);
+    symbol_t label_else = intern_cstring(".L_diamond_else");
+    symbol_t label_join = intern_cstring(".L_diamond_join");
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), label_else);
+    ir_emit_copy(ir_function, imm(1), reg(1));
+    ir_emit_jump(ir_function, label_join);
+    ir_emit_label(ir_function, label_else);
+    ir_emit_copy(ir_function, imm(2), reg(1));
+    ir_emit_label(ir_function, label_join);
+    emit_return(ir_function, reg(1));
+
+    ir_cfg_t cfg;
+    CHECK(ir_cfg_build(ir_function, &cfg));
+    CHECK(cfg.block_count == 4 && cfg.rpo_count == 4);
+    CHECK(ir_cfg_block_of_label(&cfg, label_else) == 2 && ir_cfg_block_of_label(&cfg, label_join) == 3);
+
+    CHECK(cfg.blocks[0].idom == IR_CFG_NO_BLOCK);
+    for (uint32_t b = 1; b < 4; b++)
+    {
+        CHECK(cfg.blocks[b].idom == 0);
+    }
+    CHECK(cfg.blocks[0].frontier.count == 0 && cfg.blocks[3].frontier.count == 0);
+    for (uint32_t b = 1; b < 3; b++)
+    {
+        CHECK(cfg.blocks[b].frontier.count == 1 && cfg.blocks[b].frontier.items[0] == 3);
+    }
+
+    CHECK(ir_cfg_dominates(&cfg, 0, 3));
+    CHECK(ir_cfg_dominates(&cfg, 3, 3));
+    CHECK(!ir_cfg_dominates(&cfg, 1, 3));
+    CHECK(!ir_cfg_dominates(&cfg, 2, 3));
+    CHECK(!ir_cfg_dominates(&cfg, 3, 0));
+
+    ir_cfg_linearize(&cfg);
+    ir_cfg_free(&cfg);
+    CHECK(instruction_count(ir_function) == 7);
+}
+
+// Runs the copies from instruction index on over values, returns the index of the first other instruction
+static size_t run_copies(ir_function_t *ir_function, size_t index, int *values)
+{
+    ir_instruction_t *instruction;
+    while ((instruction = instruction_at(ir_function, index)) && instruction->type == IR_INSTR_COPY)
+    {
+        ir_instruction_copy_t *copy = &instruction->instruction.copy_instr;
+        values[copy->destination->value.variable.vreg] = copy->source->type == IR_VAL_CONSTANT_INT
+                                                             ? copy->source->value.constant_int
+                                                             : values[copy->source->value.variable.vreg];
+        index++;
+    }
+    return index;
+}
+
+// The parallel copy %0, %1, %2, %3 = %1, %2, %0, %0 holds a cycle, one temporary breaks it
+static void test_ssa_sequentialize_cycle(void)
+{
+    ir_function_t *ir_function = new_function(4);
+    emit_return(ir_function, imm(0));
+
+    ir_cfg_t cfg;
+    CHECK(ir_cfg_build(ir_function, &cfg));
+    ir_ssa_move_t moves[] = {
+        {reg(0), reg(1)},
+        {reg(1), reg(2)},
+        {reg(2), reg(0)},
+        {reg(3), reg(0)},
+    };
+    ir_instruction_t *last = ir_block_last(&cfg.blocks[0]);
+    CHECK(ir_ssa_sequentialize(&cfg, &cfg.blocks[0], &last->link, moves, 4));
+    ir_cfg_linearize(&cfg);
+    ir_cfg_free(&cfg);
+
+    CHECK(ir_function->vreg_count == 5);
+    int values[] = {100, 101, 102, 103, 104};
+    CHECK(run_copies(ir_function, 0, values) == 5);
+    CHECK(values[0] == 101 && values[1] == 102 && values[2] == 100 && values[3] == 100);
+    CHECK(instruction_at(ir_function, 5)->type == IR_INSTR_RETURN);
+}
+
+// Gives the phi at link argument first from block 0 and argument second from anywhere else
+static void set_phi_arguments(instr_link_t *link, uint32_t first, uint32_t second)
+{
+    ir_instruction_phi_t *phi = &INSTR_LIST_ENTRY(link, ir_instruction_t, link)->instruction.phi_instr;
+    for (uint32_t i = 0; i < phi->argument_count; i++)
+    {
+        phi->arguments[i]->value.variable.vreg = phi->predecessors[i] == 0 ? first : second;
+    }
+}
+
+/*
+Two phis that swap their values around a loop:
+
+        %0 = 1              block 0
+        %1 = 2
+    .L_loop:                block 1
+        %2 = phi(%0, %3)
+        %3 = phi(%1, %2)
+        jnz %4, .L_loop
+        return %2           block 2
+
+The back edge leaves a block with two successors for one with two predecessors, its copies
+get a block of their own. That block cannot go between the loop and the return, which the
+loop falls through to, so it goes after the return.
+*/
+static void test_ssa_destruct_swap(void)
+{
+    ir_function_t *ir_function = new_function(5);
+    symbol_t label_loop = intern_cstring(".L_swap_loop");
+    ir_emit_copy(ir_function, imm(1), reg(0));
+    ir_emit_copy(ir_function, imm(2), reg(1));
+    ir_emit_label(ir_function, label_loop);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_NOT_ZERO, reg(4), label_loop);
+    emit_return(ir_function, reg(2));
+
+    ir_cfg_t cfg;
+    CHECK(ir_cfg_build(ir_function, &cfg));
+    CHECK(cfg.blocks[1].predecessors.count == 2);
+    CHECK(ir_ssa_insert_phi(&cfg, &cfg.blocks[1], 3, SYMBOL_NONE));
+    set_phi_arguments(ir_ssa_after_labels(&cfg.blocks[1]), 1, 2);
+    CHECK(ir_ssa_insert_phi(&cfg, &cfg.blocks[1], 2, SYMBOL_NONE));
+    set_phi_arguments(ir_ssa_after_labels(&cfg.blocks[1]), 0, 3);
+    CHECK(ir_ssa_destruct(&cfg));
+    ir_cfg_linearize(&cfg);
+    ir_cfg_free(&cfg);
+
+    CHECK(count_type(ir_function, IR_INSTR_PHI) == 0);
+    int values[] = {100, 101, 102, 103, 104, 105};
+    CHECK(run_copies(ir_function, 0, values) == 4);
+    CHECK(values[2] == 1 && values[3] == 2);
+
+    ir_instruction_t *loop = instruction_at(ir_function, 5);
+    CHECK(loop->type == IR_INSTR_JUMP_IF_NOT_ZERO && loop->instruction.jz_instr.target->name != label_loop);
+    ir_instruction_t *exit = instruction_at(ir_function, 6);
+    CHECK(exit->type == IR_INSTR_RETURN && is_reg(exit->instruction.return_instr.value, 2));
+
+    ir_instruction_t *split = instruction_at(ir_function, 7);
+    CHECK(split->type == IR_INSTR_LABEL &&
+          split->instruction.label_instr.identifier->name == loop->instruction.jz_instr.target->name);
+    values[2] = 102;
+    values[3] = 103;
+    ir_instruction_t *back = instruction_at(ir_function, run_copies(ir_function, 8, values));
+    CHECK(values[2] == 103 && values[3] == 102);
+    CHECK(back->type == IR_INSTR_JUMP && back->instruction.jmp_instr.target->name == label_loop);
+}
+
+static bool reads(ir_function_t *ir_function, uint32_t vreg)
+{
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        for (uint32_t u = 0; u < ir_instruction_use_count(instruction); u++)
+        {
+            if (is_reg(ir_instruction_use(instruction, u), vreg))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The first instruction other than a label at or after the place label is defined
+static ir_instruction_t *at_label(ir_function_t *ir_function, symbol_t label)
+{
+    bool found = false;
+    INSTR_LIST_FOR_EACH(link, &ir_function->body)
+    {
+        ir_instruction_t *instruction = INSTR_LIST_ENTRY(link, ir_instruction_t, link);
+        if (instruction->type == IR_INSTR_LABEL)
+        {
+            found = found || instruction->instruction.label_instr.identifier->name == label;
+        }
+        else if (found)
+        {
+            return instruction;
+        }
+    }
+    return NULL;
+}
+
+static bool returns_constant(const ir_instruction_t *instruction, int constant_int)
+{
+    return instruction && instruction->type == IR_INSTR_RETURN &&
+           instruction->instruction.return_instr.value->type == IR_VAL_CONSTANT_INT &&
+           instruction->instruction.return_instr.value->value.constant_int == constant_int;
+}
+
+static bool copies_constant(const ir_instruction_t *instruction, int constant_int)
+{
+    return instruction && instruction->type == IR_INSTR_COPY &&
+           instruction->instruction.copy_instr.source->type == IR_VAL_CONSTANT_INT &&
+           instruction->instruction.copy_instr.source->value.constant_int == constant_int;
+}
+
+// The operations C leaves undefined for these operands come first, registers 0 to 5
+static ir_function_t *undefined_operations(void)
+{
+    ir_function_t *ir_function = new_function(9);
+    emit_binary(ir_function, IR_BINARY_DIVIDE, imm(7), imm(0), 0);
+    emit_binary(ir_function, IR_BINARY_REM, imm(7), imm(0), 1);
+    emit_binary(ir_function, IR_BINARY_DIVIDE, imm(INT_MIN), imm(-1), 2);
+    emit_binary(ir_function, IR_BINARY_REM, imm(INT_MIN), imm(-1), 3);
+    emit_binary(ir_function, IR_BINARY_BITWISE_LEFT_SHIFT, imm(1), imm(32), 4);
+    emit_binary(ir_function, IR_BINARY_BITWISE_RIGHT_SHIFT, imm(1), imm(-1), 5);
+    emit_binary(ir_function, IR_BINARY_DIVIDE, imm(-7), imm(2), 6);
+    emit_binary(ir_function, IR_BINARY_BITWISE_LEFT_SHIFT, imm(1), imm(31), 7);
+    emit_binary(ir_function, IR_BINARY_BITWISE_RIGHT_SHIFT, imm(-8), imm(1), 8);
+    emit_return(ir_function, reg(0));
+    return ir_function;
+}
+
+// x / 0, INT_MIN / -1 and shift counts outside 0..31 trap or depend on the target, they stay
+static void test_fold_keeps_undefined(void)
+{
+    ir_function_t *ir_function = undefined_operations();
+    CHECK(run_pass(ir_function, ir_fold_constants));
+    for (size_t i = 0; i < 6; i++)
+    {
+        CHECK(instruction_at(ir_function, i)->type == IR_INSTR_BINARY);
+    }
+
+    // C division truncates, a right shift of a negative value keeps its sign
+    CHECK(copies_constant(instruction_at(ir_function, 6), -3));
+    CHECK(copies_constant(instruction_at(ir_function, 7), INT_MIN));
+    CHECK(copies_constant(instruction_at(ir_function, 8), -4));
+}
+
+// SCCP evaluates through the same rules and deletes only the definitions it could evaluate
+static void test_sccp_keeps_undefined(void)
+{
+    ir_function_t *ir_function = undefined_operations();
+    CHECK(run_pass(ir_function, ir_sccp));
+    CHECK(instruction_count(ir_function) == 7);
+    for (size_t i = 0; i < 6; i++)
+    {
+        CHECK(instruction_at(ir_function, i)->type == IR_INSTR_BINARY);
+    }
+    CHECK(is_reg(instruction_at(ir_function, 6)->instruction.return_instr.value, 0));
+}
+
+
+/*
+The test of %0 cannot be decided and stays, since the division is never folded, the test of
+%1 = 0 always jumps and becomes a plain jump:
+
+        %0 = 1 / 0
+        jz %0, .L_other
+        %1 = 0
+        jz %1, .L_taken
+        return 1
+    .L_taken:
+        return 2
+    .L_other:
+        return 3
+*/
+static void test_sccp_branches(void)
+{
+    ir_function_t *ir_function = new_function(2);
+    symbol_t label_taken = intern_cstring(".L_sccp_taken");
+    symbol_t label_other = intern_cstring(".L_sccp_other");
+    emit_binary(ir_function, IR_BINARY_DIVIDE, imm(1), imm(0), 0);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), label_other);
+    ir_emit_copy(ir_function, imm(0), reg(1));
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(1), label_taken);
+    emit_return(ir_function, imm(1));
+    ir_emit_label(ir_function, label_taken);
+    emit_return(ir_function, imm(2));
+    ir_emit_label(ir_function, label_other);
+    emit_return(ir_function, imm(3));
+
+    CHECK(run_pass(ir_function, ir_sccp));
+    ir_instruction_t *unknown = instruction_at(ir_function, 1);
+    CHECK(unknown->type == IR_INSTR_JUMP_IF_ZERO && is_reg(unknown->instruction.jz_instr.condition, 0));
+    CHECK(returns_constant(at_label(ir_function, unknown->instruction.jz_instr.target->name), 3));
+    CHECK(count_type(ir_function, IR_INSTR_JUMP_IF_ZERO) == 1);
+    CHECK(!reads(ir_function, 1));
+
+    ir_instruction_t *known = instruction_at(ir_function, 2);
+    CHECK(known->type == IR_INSTR_JUMP);
+    CHECK(returns_constant(at_label(ir_function, known->instruction.jmp_instr.target->name), 2));
+}
+
+// %2 = %0 * %1; %3 = %1 * %0 computes the same value twice
+static void test_gvn_commutative(void)
+{
+    ir_function_t *ir_function = new_function(5);
+    emit_binary(ir_function, IR_BINARY_MULTIPLY, reg(0), reg(1), 2);
+    emit_binary(ir_function, IR_BINARY_MULTIPLY, reg(1), reg(0), 3);
+    emit_binary(ir_function, IR_BINARY_ADD, reg(2), reg(3), 4);
+    emit_return(ir_function, reg(4));
+
+    CHECK(run_pass(ir_function, ir_global_value_numbering));
+    CHECK(instruction_at(ir_function, 0)->type == IR_INSTR_BINARY);
+    CHECK(is_copy(instruction_at(ir_function, 1), 3, 2));
+    CHECK(instruction_at(ir_function, 2)->type == IR_INSTR_BINARY);
+}
+
+// a > b is looked up as b < a, a - b and b - a stay apart
+static void test_gvn_operand_order(void)
+{
+    ir_function_t *ir_function = new_function(7);
+    emit_binary(ir_function, IR_BINARY_GREATER_THAN, reg(0), reg(1), 2);
+    emit_binary(ir_function, IR_BINARY_LESS_THAN, reg(1), reg(0), 3);
+    emit_binary(ir_function, IR_BINARY_SUBTRACT, reg(0), reg(1), 4);
+    emit_binary(ir_function, IR_BINARY_SUBTRACT, reg(1), reg(0), 5);
+    emit_binary(ir_function, IR_BINARY_ADD, reg(4), reg(5), 6);
+    emit_return(ir_function, reg(6));
+
+    CHECK(run_pass(ir_function, ir_global_value_numbering));
+    CHECK(is_copy(instruction_at(ir_function, 1), 3, 2));
+    CHECK(instruction_at(ir_function, 2)->type == IR_INSTR_BINARY);
+    CHECK(instruction_at(ir_function, 3)->type == IR_INSTR_BINARY);
+}
+
+// %1 and %2 are never read, %3 is read in a later block
+static void test_dce_dead_chain(void)
+{
+    ir_function_t *ir_function = new_function(4);
+    symbol_t zero = intern_cstring(".L_zero");
+    emit_binary(ir_function, IR_BINARY_ADD, reg(0), imm(1), 1);
+    emit_binary(ir_function, IR_BINARY_MULTIPLY, reg(1), imm(2), 2);
+    emit_binary(ir_function, IR_BINARY_SUBTRACT, reg(0), imm(1), 3);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), zero);
+    emit_return(ir_function, reg(3));
+    ir_emit_label(ir_function, zero);
+    emit_return(ir_function, reg(0));
+
+    CHECK(run_pass(ir_function, ir_eliminate_dead_code));
+    CHECK(instruction_count(ir_function) == 5);
+    CHECK(is_reg(instruction_at(ir_function, 0)->instruction.binary_instr.destination, 3));
+    CHECK(instruction_at(ir_function, 1)->type == IR_INSTR_JUMP_IF_ZERO);
+}
+
+// Removing the dead use of %1 in the second block makes its definition in the first one dead too
+static void test_dce_across_blocks(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    symbol_t done = intern_cstring(".L_done");
+    emit_binary(ir_function, IR_BINARY_ADD, reg(0), imm(1), 1);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), done);
+    emit_binary(ir_function, IR_BINARY_MULTIPLY, reg(1), imm(2), 2);
+    ir_emit_label(ir_function, done);
+    emit_return(ir_function, reg(0));
+
+    CHECK(run_pass(ir_function, ir_eliminate_dead_code));
+    CHECK(instruction_count(ir_function) == 3);
+    CHECK(instruction_at(ir_function, 0)->type == IR_INSTR_JUMP_IF_ZERO);
+}
+
+// Uses of a copy read its source instead
+static void test_copy_propagation(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    ir_emit_copy(ir_function, reg(0), reg(1));
+    emit_binary(ir_function, IR_BINARY_ADD, reg(1), imm(1), 2);
+    emit_return(ir_function, reg(2));
+
+    CHECK(run_pass(ir_function, ir_propagate_copies));
+    CHECK(is_reg(instruction_at(ir_function, 1)->instruction.binary_instr.left, 0));
+}
+
+// %2 = %1 + %0; %1 = %2 computes straight into %1, the backend loads %1 before adding %0
+static void test_coalesce_left_operand(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    emit_binary(ir_function, IR_BINARY_ADD, reg(1), reg(0), 2);
+    ir_emit_copy(ir_function, reg(2), reg(1));
+    emit_return(ir_function, reg(1));
+
+    CHECK(run_pass(ir_function, ir_coalesce_copies));
+    CHECK(instruction_count(ir_function) == 2);
+    CHECK(is_reg(instruction_at(ir_function, 0)->instruction.binary_instr.destination, 1));
+}
+
+// %2 = %0 - %1; %1 = %2 must stay, mov %1, %0; sub %1, %1 would read the overwritten %1
+static void test_coalesce_right_operand(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    emit_binary(ir_function, IR_BINARY_SUBTRACT, reg(0), reg(1), 2);
+    ir_emit_copy(ir_function, reg(2), reg(1));
+    emit_return(ir_function, reg(1));
+
+    CHECK(!run_pass(ir_function, ir_coalesce_copies));
+    CHECK(instruction_count(ir_function) == 3);
+    CHECK(is_copy(instruction_at(ir_function, 1), 1, 2));
+}
+
+/*
+if (%0 && %1) return 1; else return 0; as the generator lowers it:
+
+        jz %0, .L_false
+        jz %1, .L_false
+        %2 = 1
+        jmp .L_end
+    .L_false:
+        %2 = 0
+    .L_end:
+        jz %2, .L_else
+        return 1
+    .L_else:
+        return 0
+
+Both jz go straight to .L_else and %2 is not materialized any more.
+*/
+static void test_branch_fuse_and(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    symbol_t label_false = intern_cstring(".L_and_false");
+    symbol_t label_end = intern_cstring(".L_and_end");
+    symbol_t label_else = intern_cstring(".L_and_else");
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), label_false);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(1), label_false);
+    ir_emit_copy(ir_function, imm(1), reg(2));
+    ir_emit_jump(ir_function, label_end);
+    ir_emit_label(ir_function, label_false);
+    ir_emit_copy(ir_function, imm(0), reg(2));
+    ir_emit_label(ir_function, label_end);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(2), label_else);
+    emit_return(ir_function, imm(1));
+    ir_emit_label(ir_function, label_else);
+    emit_return(ir_function, imm(0));
+
+    CHECK(run_pass(ir_function, ir_simplify_branches));
+    CHECK(!reads(ir_function, 2));
+    for (size_t i = 0; i < 2; i++)
+    {
+        ir_instruction_t *jump = instruction_at(ir_function, i);
+        CHECK(jump->type == IR_INSTR_JUMP_IF_ZERO && is_reg(jump->instruction.jz_instr.condition, i));
+        CHECK(returns_constant(at_label(ir_function, jump->instruction.jz_instr.target->name), 0));
+    }
+
+    // a label may have been added where the redirected jump used to go
+    ir_instruction_t *fall_through = instruction_at(ir_function, 2);
+    if (fall_through && fall_through->type == IR_INSTR_LABEL)
+    {
+        fall_through = instruction_at(ir_function, 3);
+    }
+    CHECK(returns_constant(fall_through, 1));
+}
+
+// The same for %0 || %1, where jnz leads to %2 = 1 and falling through to %2 = 0
+static void test_branch_fuse_or(void)
+{
+    ir_function_t *ir_function = new_function(3);
+    symbol_t label_true = intern_cstring(".L_or_true");
+    symbol_t label_end = intern_cstring(".L_or_end");
+    symbol_t label_else = intern_cstring(".L_or_else");
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_NOT_ZERO, reg(0), label_true);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_NOT_ZERO, reg(1), label_true);
+    ir_emit_copy(ir_function, imm(0), reg(2));
+    ir_emit_jump(ir_function, label_end);
+    ir_emit_label(ir_function, label_true);
+    ir_emit_copy(ir_function, imm(1), reg(2));
+    ir_emit_label(ir_function, label_end);
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(2), label_else);
+    emit_return(ir_function, imm(1));
+    ir_emit_label(ir_function, label_else);
+    emit_return(ir_function, imm(0));
+
+    CHECK(run_pass(ir_function, ir_simplify_branches));
+    CHECK(!reads(ir_function, 2));
+    for (size_t i = 0; i < 2; i++)
+    {
+        ir_instruction_t *jump = instruction_at(ir_function, i);
+        CHECK(jump->type == IR_INSTR_JUMP_IF_NOT_ZERO && is_reg(jump->instruction.jnz_instr.condition, i));
+        CHECK(returns_constant(at_label(ir_function, jump->instruction.jnz_instr.target->name), 1));
+    }
+}
+
+// A jump into a chain of blocks that only jump on lands where the chain ends, a cycle of them stays put
+static void test_branch_thread_chain(void)
+{
+    ir_function_t *ir_function = new_function(1);
+    symbol_t label_first = intern_cstring(".L_chain_first");
+    symbol_t label_second = intern_cstring(".L_chain_second");
+    symbol_t label_target = intern_cstring(".L_chain_target");
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), label_first);
+    emit_return(ir_function, imm(1));
+    ir_emit_label(ir_function, label_second);
+    ir_emit_jump(ir_function, label_target);
+    ir_emit_label(ir_function, label_first);
+    ir_emit_jump(ir_function, label_second);
+    ir_emit_label(ir_function, label_target);
+    emit_return(ir_function, imm(0));
+
+    CHECK(run_pass(ir_function, ir_simplify_branches));
+    ir_instruction_t *jump = instruction_at(ir_function, 0);
+    CHECK(jump->type == IR_INSTR_JUMP_IF_ZERO);
+    CHECK(returns_constant(at_label(ir_function, jump->instruction.jz_instr.target->name), 0));
+    CHECK(instruction_count(ir_function) == 4);
+
+    ir_function = new_function(1);
+    symbol_t label_ping = intern_cstring(".L_cycle_ping");
+    symbol_t label_pong = intern_cstring(".L_cycle_pong");
+    ir_emit_conditional_jump(ir_function, IR_INSTR_JUMP_IF_ZERO, reg(0), label_ping);
+    emit_return(ir_function, imm(1));
+    ir_emit_label(ir_function, label_ping);
+    ir_emit_jump(ir_function, label_pong);
+    ir_emit_label(ir_function, label_pong);
+    ir_emit_jump(ir_function, label_ping);
+
+    run_pass(ir_function, ir_simplify_branches);
+    CHECK(instruction_at(ir_function, 0)->type == IR_INSTR_JUMP_IF_ZERO);
+    CHECK(returns_constant(instruction_at(ir_function, 1), 1));
+}
+
+static asm_program_t *new_asm_program(void)
+{
+    asm_program_t *asm_program = (asm_program_t *)allocate(sizeof(asm_program_t));
+    asm_function_t *asm_function = (asm_function_t *)allocate(sizeof(asm_function_t));
+    asm_program->base.type = ASM_NODE_PROGRAM;
+    asm_program->base.parent = NULL;
+    asm_program->function = asm_function;
+    asm_function->base.type = ASM_NODE_FUNCTION;
+    asm_function->base.parent = &asm_program->base;
+    asm_function->name = NULL;
+    instr_list_init(&asm_function->instructions);
+    asm_function->vreg_count = 0;
+    return asm_program;
+}
+
+static asm_operand_t *new_asm_operand(asm_operand_type_t type, int value)
+{
+    asm_operand_t *operand = (asm_operand_t *)allocate(sizeof(asm_operand_t));
+    operand->base.type = ASM_NODE_OPERAND;
+    operand->base.parent = NULL;
+    operand->type = type;
+    switch (type)
+    {
+    case OPERAND_IMMEDIATE:
+        operand->operand.immediate.value = value;
+        break;
+    case OPERAND_REGISTER:
+        operand->operand.reg.reg_no = (asm_reg_no_t)value;
+        break;
+    case OPERAND_STACK:
+        operand->operand.stack.offset = value;
+        break;
+    case OPERAND_PSEUDO:
+        operand->operand.pseudo.vreg = (uint32_t)value;
+        break;
+    }
+    return operand;
+}
+
+static asm_instruction_t *emit_asm(asm_program_t *asm_program, asm_instruction_type_t type, asm_operand_t *first,
+                                   asm_operand_t *second)
+{
+    asm_instruction_t *instruction = (asm_instruction_t *)allocate(sizeof(asm_instruction_t));
+    instruction->base.type = ASM_NODE_INSTRUCTION;
+    instruction->base.parent = &asm_program->function->base;
+    instruction->type = type;
+    if (type == INSTRUCTION_MOV)
+    {
+        instruction->instr.mov.src = first;
+        instruction->instr.mov.dst = second;
+    }
+    else if (type == INSTRUCTION_CMP)
+    {
+        instruction->instr.cmp.first_operand = first;
+        instruction->instr.cmp.second_operand = second;
+    }
+    instr_list_push_back(&asm_program->function->instructions, &instruction->link);
+    return instruction;
+}
+
+static asm_instruction_t *asm_instruction_at(asm_program_t *asm_program, size_t index)
+{
+    INSTR_LIST_FOR_EACH(link, &asm_program->function->instructions)
+    {
+        if (!index--)
+        {
+            return INSTR_LIST_ENTRY(link, asm_instruction_t, link);
+        }
+    }
+    return NULL;
+}
+
+static bool is_asm_operand(const asm_operand_t *operand, asm_operand_type_t type, int value)
+{
+    return asm_operand_equal(operand, new_asm_operand(type, value));
+}
+
+// mov [s], r10d; cmp [s], 0 keeps the store and tests the register instead
+static void test_peephole_compare_stored(void)
+{
+    asm_program_t *asm_program = new_asm_program();
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_REGISTER, ASM_REG_R10), new_asm_operand(OPERAND_STACK, -4));
+    emit_asm(asm_program, INSTRUCTION_CMP, new_asm_operand(OPERAND_STACK, -4), new_asm_operand(OPERAND_IMMEDIATE, 0));
+    emit_asm(asm_program, INSTRUCTION_RET, NULL, NULL);
+
+    CHECK(asm_peephole_pass(asm_program));
+    CHECK(asm_program->function->instructions.count == 3);
+    CHECK(asm_instruction_at(asm_program, 0)->type == INSTRUCTION_MOV);
+
+    asm_instruction_t *test = asm_instruction_at(asm_program, 1);
+    CHECK(test->type == INSTRUCTION_TEST);
+    CHECK(is_asm_operand(test->instr.test.first_operand, OPERAND_REGISTER, ASM_REG_R10));
+    CHECK(is_asm_operand(test->instr.test.second_operand, OPERAND_REGISTER, ASM_REG_R10));
+}
+
+// mov r10d, 5; mov [s], r10d stores the constant directly, unless r10d is read afterwards
+static void test_peephole_move_chain(void)
+{
+    asm_program_t *asm_program = new_asm_program();
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_IMMEDIATE, 5), new_asm_operand(OPERAND_REGISTER, ASM_REG_R10));
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_REGISTER, ASM_REG_R10), new_asm_operand(OPERAND_STACK, -8));
+    emit_asm(asm_program, INSTRUCTION_RET, NULL, NULL);
+
+    CHECK(asm_peephole_pass(asm_program));
+    CHECK(asm_program->function->instructions.count == 2);
+    asm_instruction_t *mov = asm_instruction_at(asm_program, 0);
+    CHECK(is_asm_operand(mov->instr.mov.src, OPERAND_IMMEDIATE, 5));
+    CHECK(is_asm_operand(mov->instr.mov.dst, OPERAND_STACK, -8));
+
+    asm_program = new_asm_program();
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_IMMEDIATE, 5), new_asm_operand(OPERAND_REGISTER, ASM_REG_R10));
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_REGISTER, ASM_REG_R10), new_asm_operand(OPERAND_STACK, -8));
+    emit_asm(asm_program, INSTRUCTION_MOV, new_asm_operand(OPERAND_REGISTER, ASM_REG_R10), new_asm_operand(OPERAND_STACK, -12));
+    emit_asm(asm_program, INSTRUCTION_RET, NULL, NULL);
+
+    CHECK(asm_peephole_pass(asm_program));
+    CHECK(asm_program->function->instructions.count == 4);
+}
+
+// sub rsp, 0 goes, an allocation of actual stack slots stays
+static void test_peephole_empty_stack_allocation(void)
+{
+    asm_program_t *asm_program = new_asm_program();
+    emit_asm(asm_program, INSTRUCTION_ALLOCATE_STACK, NULL, NULL)->instr.alloc_stack.alloc_size = 0;
+    emit_asm(asm_program, INSTRUCTION_RET, NULL, NULL);
+
+    CHECK(asm_peephole_pass(asm_program));
+    CHECK(asm_program->function->instructions.count == 1);
+    CHECK(asm_instruction_at(asm_program, 0)->type == INSTRUCTION_RET);
+
+    asm_program = new_asm_program();
+    emit_asm(asm_program, INSTRUCTION_ALLOCATE_STACK, NULL, NULL)->instr.alloc_stack.alloc_size = 16;
+    emit_asm(asm_program, INSTRUCTION_RET, NULL, NULL);
+
+    CHECK(asm_peephole_pass(asm_program));
+    CHECK(asm_program->function->instructions.count == 2);
+}
+
+int main(void)
+{
+    test_dominators_diamond();
+    test_ssa_sequentialize_cycle();
+    test_ssa_destruct_swap();
+    test_fold_keeps_undefined();
+    test_sccp_keeps_undefined();
+    test_sccp_branches();
+    test_gvn_commutative();
+    test_gvn_operand_order();
+    test_dce_dead_chain();
+    test_dce_across_blocks();
+    test_copy_propagation();
+    test_coalesce_left_operand();
+    test_coalesce_right_operand();
+    test_branch_fuse_and();
+    test_branch_fuse_or();
+    test_branch_thread_chain();
+    test_peephole_compare_stored();
+    test_peephole_move_chain();
+    test_peephole_empty_stack_allocation();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("All pass tests passed\n");
+    return EXIT_SUCCESS;
+}